@@ -0,0 +1,70 @@
+#include <cstddef>
+#include <memory_resource>
+
+#include "capture-arena.h"
+#include "dev-logger.h"
+
+CountingResource::CountingResource(std::pmr::memory_resource *upstream)
+    : upstream(upstream) {}
+
+void *CountingResource::do_allocate(size_t bytes, size_t alignment)
+{
+    this->allocations++;
+    this->allocatedBytes += bytes;
+    return this->upstream->allocate(bytes, alignment);
+}
+
+void CountingResource::do_deallocate(void *p, size_t bytes, size_t alignment)
+{
+    this->upstream->deallocate(p, bytes, alignment);
+}
+
+bool CountingResource::do_is_equal(const std::pmr::memory_resource &other) const noexcept
+{
+    return this == &other;
+}
+
+CaptureArena::CaptureArena(size_t initialSize)
+{
+    this->blockSize = initialSize;
+    this->block.reset(new std::byte[this->blockSize]);
+    this->monotonic.emplace(this->block.get(), this->blockSize, &this->heap);
+    this->stats.blockSize = this->blockSize;
+}
+
+std::pmr::memory_resource *CaptureArena::resource()
+{
+    return &this->monotonic.value();
+}
+
+void CaptureArena::reset()
+{
+    unsigned long long allocations = this->heap.allocations - this->allocationsAtTickStart;
+    unsigned long long bytes = this->heap.allocatedBytes - this->bytesAtTickStart;
+
+    // Releases the heap allocations, if any.
+    this->monotonic.reset();
+
+    if (allocations > 0)
+    {
+        // Grow once, so the next tick of the same size fits in the block.
+        this->blockSize = (this->blockSize + bytes) * 2;
+        DEBUG("Capture arena overflowed by {} bytes in {} allocations, grow to {} bytes",
+              bytes, allocations, this->blockSize);
+        this->block.reset(new std::byte[this->blockSize]);
+        this->stats.ticksWithHeapAllocations++;
+    }
+
+    this->monotonic.emplace(this->block.get(), this->blockSize, &this->heap);
+    this->allocationsAtTickStart = this->heap.allocations;
+    this->bytesAtTickStart = this->heap.allocatedBytes;
+
+    this->stats.ticks++;
+    this->stats.lastTickHeapAllocations = allocations;
+    this->stats.blockSize = this->blockSize;
+}
+
+CaptureArenaStats CaptureArena::getStats()
+{
+    return this->stats;
+}
@@ -0,0 +1,70 @@
+#ifndef MAIN_CAPTURE_ARENA
+#define MAIN_CAPTURE_ARENA
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+
+/// Initial size (in bytes) of a capture arena's block.
+#define CAPTURE_ARENA_INITIAL_SIZE 16384
+
+/// @brief Memory resource that counts the allocations passed on to its upstream.
+class CountingResource : public std::pmr::memory_resource
+{
+private:
+    std::pmr::memory_resource *upstream;
+
+protected:
+    void *do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void *p, size_t bytes, size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override;
+
+public:
+    unsigned long long allocations = 0;
+    unsigned long long allocatedBytes = 0;
+
+    CountingResource(std::pmr::memory_resource *upstream = std::pmr::new_delete_resource());
+};
+
+struct CaptureArenaStats
+{
+    unsigned long long ticks = 0;
+    /// @brief Ticks that did not fit in the block, and allocated from the heap.
+    unsigned long long ticksWithHeapAllocations = 0;
+    /// @brief Heap allocations made by the last tick.
+    unsigned long long lastTickHeapAllocations = 0;
+    size_t blockSize = 0;
+};
+
+/// @brief Monotonic arena a capture's snapshot and strings are allocated in.
+///        Everything is released at once when the next capture starts.
+///        When a capture does not fit, the block grows, so steady state
+///        captures make no heap allocations at all.
+class CaptureArena
+{
+private:
+    /// @brief Counts allocations that did not fit in the block.
+    CountingResource heap;
+    std::unique_ptr<std::byte[]> block;
+    size_t blockSize = 0;
+    std::optional<std::pmr::monotonic_buffer_resource> monotonic;
+
+    unsigned long long allocationsAtTickStart = 0;
+    unsigned long long bytesAtTickStart = 0;
+    CaptureArenaStats stats;
+
+public:
+    CaptureArena(size_t initialSize = CAPTURE_ARENA_INITIAL_SIZE);
+    CaptureArena(const CaptureArena &) = delete;
+    CaptureArena &operator=(const CaptureArena &) = delete;
+
+    std::pmr::memory_resource *resource();
+
+    /// @brief Release everything allocated since the last reset,
+    ///        and start a new tick.
+    void reset();
+
+    CaptureArenaStats getStats();
+};
+
+#endif /* MAIN_CAPTURE_ARENA */
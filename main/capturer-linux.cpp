@@ -0,0 +1,121 @@
+#include <dirent.h>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
+#include "capturer-linux.h"
+#include "capturer.h"
+
+/// @brief Read the target of a symbolic link such as `/proc/<pid>/exe`.
+/// @return Empty string if the link cannot be read.
+static std::string readLink(const std::string &path)
+{
+    char buffer[4096];
+    ssize_t n = readlink(path.c_str(), buffer, sizeof(buffer));
+    if (n <= 0)
+        return "";
+    return std::string(buffer, n);
+}
+
+/// @brief Read the command line of a process, with arguments separated by spaces.
+static std::string readCmdline(const std::string &procDir)
+{
+    std::ifstream f(procDir + "/cmdline", std::ios::binary);
+    std::string cmdline((std::istreambuf_iterator<char>(f)),
+                        std::istreambuf_iterator<char>());
+
+    while (!cmdline.empty() && cmdline.back() == '\0')
+        cmdline.pop_back();
+    for (auto &c : cmdline)
+        if (c == '\0')
+            c = ' ';
+    return cmdline;
+}
+
+static bool isPid(const char *name)
+{
+    if (*name == '\0')
+        return false;
+    for (; *name != '\0'; name++)
+        if (*name < '0' || *name > '9')
+            return false;
+    return true;
+}
+
+void ProcCaptureSource::getOpenedApps(std::pmr::vector<AppRecord> *apps)
+{
+    DIR *proc = opendir("/proc");
+    if (proc == nullptr)
+        return;
+
+    uid_t uid = getuid();
+    struct dirent *dirEntry;
+    struct stat st;
+
+    while ((dirEntry = readdir(proc)) != nullptr)
+    {
+        if (!isPid(dirEntry->d_name))
+            continue;
+
+        std::string procDir = std::string("/proc/") + dirEntry->d_name;
+        if (stat(procDir.c_str(), &st) != 0 || st.st_uid != uid)
+            continue;
+
+        // Kernel threads and processes of other users have no readable executable.
+        std::string path = readLink(procDir + "/exe");
+        if (path.empty())
+            continue;
+
+        AppRecord &appRecord = apps->emplace_back();
+        appRecord.path = path;
+        appRecord.title = readCmdline(procDir);
+    }
+
+    closedir(proc);
+}
+
+bool ProcCaptureSource::getForegroundApp(AppRecord *)
+{
+    return false;
+}
+
+unsigned int ProcCaptureSource::getDurationSinceLastInput()
+{
+    // Like `w`, take the most recent access of any of the user's terminals.
+    const char *ttyDirs[] = {"/dev/pts", "/dev"};
+    uid_t uid = getuid();
+    time_t latestInput = 0;
+    struct stat st;
+
+    for (auto ttyDir : ttyDirs)
+    {
+        DIR *dir = opendir(ttyDir);
+        if (dir == nullptr)
+            continue;
+
+        struct dirent *dirEntry;
+        while ((dirEntry = readdir(dir)) != nullptr)
+        {
+            std::string name(dirEntry->d_name);
+            bool isPts = std::string(ttyDir) == "/dev/pts";
+            if (!isPts && name.rfind("tty", 0) != 0)
+                continue;
+
+            std::string path = std::string(ttyDir) + "/" + name;
+            if (stat(path.c_str(), &st) != 0 || !S_ISCHR(st.st_mode) || st.st_uid != uid)
+                continue;
+            if (st.st_atime > latestInput)
+                latestInput = st.st_atime;
+        }
+        closedir(dir);
+    }
+
+    time_t now = time(nullptr);
+    if (latestInput == 0 || latestInput > now)
+        return 0;
+    return now - latestInput;
+}
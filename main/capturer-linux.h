@@ -0,0 +1,19 @@
+#ifndef MAIN_CAPTURER_LINUX
+#define MAIN_CAPTURER_LINUX
+#include <memory_resource>
+#include <vector>
+
+#include "capturer.h"
+
+/// @brief Captures the current user's processes from `/proc`.
+///        There is no notion of a focused window, so no app is active,
+///        and the idle time comes from the user's terminals.
+class ProcCaptureSource : public CaptureSource
+{
+public:
+    void getOpenedApps(std::pmr::vector<AppRecord> *apps) override;
+    bool getForegroundApp(AppRecord *app) override;
+    unsigned int getDurationSinceLastInput() override;
+};
+
+#endif /* MAIN_CAPTURER_LINUX */
@@ -0,0 +1,117 @@
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "json.hpp"
+
+#include "capturer-replay.h"
+#include "capturer.h"
+#include "dev-logger.h"
+
+ReplayCaptureSource::ReplayCaptureSource(const std::string &path, unsigned int syntheticApps)
+{
+    if (!path.empty())
+    {
+        this->loadFromFile(path);
+        return;
+    }
+
+    INFO("Generate synthetic snapshots with {} apps each", syntheticApps);
+    this->synthetic = true;
+    this->syntheticApps = syntheticApps;
+    this->snapshots.resize(1);
+}
+
+void ReplayCaptureSource::loadFromFile(const std::string &path)
+{
+    INFO("Load snapshots to replay from `{}`", path);
+    std::ifstream f(path);
+    if (!f)
+        throw std::runtime_error("Cannot open replay file `" + path + "`");
+
+    std::string line;
+    while (std::getline(f, line))
+    {
+        if (line.empty() || line == "\r")
+            continue;
+
+        auto entry = nlohmann::json::parse(line);
+        ReplaySnapshot snapshot;
+
+        if (entry.contains("durationSinceLastInput"))
+            entry.at("durationSinceLastInput").get_to(snapshot.durationSinceLastInput);
+
+        if (entry.contains("apps"))
+            for (auto const &app : entry.at("apps"))
+            {
+                AppRecord appRecord;
+                app.at("path").get_to(appRecord.path);
+                app.at("title").get_to(appRecord.title);
+                appRecord.isActive = app.value("isActive", false);
+                snapshot.apps.push_back(appRecord);
+            }
+
+        if (entry.contains("focus"))
+        {
+            AppRecord appRecord;
+            entry.at("focus").at("path").get_to(appRecord.path);
+            entry.at("focus").at("title").get_to(appRecord.title);
+            appRecord.isActive = true;
+            snapshot.apps.push_back(appRecord);
+        }
+
+        this->snapshots.push_back(snapshot);
+    }
+
+    if (this->snapshots.empty())
+        throw std::runtime_error("Replay file `" + path + "` has no snapshots");
+    INFO("Loaded {} snapshots to replay", this->snapshots.size());
+}
+
+void ReplayCaptureSource::generateSynthetic(ReplaySnapshot *snapshot)
+{
+    this->syntheticCount++;
+    snapshot->apps.resize(this->syntheticApps);
+
+    // The active app and one title change on every snapshot,
+    // so focus probes have something to log.
+    size_t active = this->syntheticCount % (this->syntheticApps == 0 ? 1 : this->syntheticApps);
+    for (size_t i = 0; i < snapshot->apps.size(); i++)
+    {
+        auto &app = snapshot->apps[i];
+        app.path = "/synthetic/app-" + std::to_string(i);
+        app.title = "Synthetic window " + std::to_string(i);
+        app.isActive = i == active;
+    }
+    if (!snapshot->apps.empty())
+        snapshot->apps[active].title += " #" + std::to_string(this->syntheticCount);
+}
+
+void ReplayCaptureSource::getOpenedApps(std::pmr::vector<AppRecord> *apps)
+{
+    auto &snapshot = this->snapshots[this->position];
+    apps->insert(apps->end(), snapshot.apps.begin(), snapshot.apps.end());
+}
+
+bool ReplayCaptureSource::getForegroundApp(AppRecord *app)
+{
+    for (auto const &appRecord : this->snapshots[this->position].apps)
+        if (appRecord.isActive)
+        {
+            *app = appRecord;
+            return true;
+        }
+    return false;
+}
+
+unsigned int ReplayCaptureSource::getDurationSinceLastInput()
+{
+    if (this->synthetic)
+        this->generateSynthetic(&this->snapshots[0]);
+    else if (this->started)
+        this->position = (this->position + 1) % this->snapshots.size();
+
+    this->started = true;
+    return this->snapshots[this->position].durationSinceLastInput;
+}
@@ -0,0 +1,44 @@
+#ifndef MAIN_CAPTURER_REPLAY
+#define MAIN_CAPTURER_REPLAY
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+#include "capturer.h"
+
+struct ReplaySnapshot
+{
+    std::vector<AppRecord> apps;
+    unsigned int durationSinceLastInput = 0;
+};
+
+/// @brief Replays snapshots recorded in a plain JSON log file,
+///        or generates synthetic ones, as fast as they are asked for.
+///        Every capture starts by asking for the idle duration,
+///        which moves on to the next snapshot.
+class ReplayCaptureSource : public CaptureSource
+{
+private:
+    std::vector<ReplaySnapshot> snapshots;
+    size_t position = 0;
+    bool started = false;
+
+    bool synthetic = false;
+    unsigned int syntheticApps = 0;
+    unsigned long long syntheticCount = 0;
+
+    void loadFromFile(const std::string &path);
+    void generateSynthetic(ReplaySnapshot *snapshot);
+
+public:
+    /// @param path Plain (`.json.log`) log file to replay, looping at the end.
+    ///             When empty, synthetic snapshots are generated instead.
+    /// @param syntheticApps Number of apps in each synthetic snapshot.
+    ReplayCaptureSource(const std::string &path, unsigned int syntheticApps);
+
+    void getOpenedApps(std::pmr::vector<AppRecord> *apps) override;
+    bool getForegroundApp(AppRecord *app) override;
+    unsigned int getDurationSinceLastInput() override;
+};
+
+#endif /* MAIN_CAPTURER_REPLAY */
@@ -0,0 +1,130 @@
+#include <Windows.h>
+#include <memory_resource>
+#include <psapi.h>
+#include <string>
+#include <vector>
+
+#include "capturer-win32.h"
+#include "capturer.h"
+#include "helpers.h"
+#include "transcoder.h"
+
+static BOOL CALLBACK enumWindowCallback(HWND hWnd, LPARAM lparam);
+const std::string &getWindowProcessPath(HWND hWnd, ProcessCache *processCache);
+
+struct CallbackParams
+{
+    std::pmr::vector<AppRecord> *pApps;
+    HWND activeWindow;
+    ProcessCache *processCache;
+    /// @brief Reused for every window title, allocated with the apps.
+    std::pmr::vector<wchar_t> titleBuffer;
+
+    CallbackParams(std::pmr::vector<AppRecord> *apps) : pApps(apps), titleBuffer(apps->get_allocator()){};
+};
+
+void WindowsCaptureSource::getOpenedApps(std::pmr::vector<AppRecord> *apps)
+{
+    struct CallbackParams lparam(apps);
+    lparam.activeWindow = GetForegroundWindow();
+    lparam.processCache = &this->processCache;
+
+    this->processCache.beginCapture();
+    EnumWindows(enumWindowCallback, reinterpret_cast<LPARAM>(&lparam));
+    this->processCache.endCapture();
+}
+
+bool WindowsCaptureSource::getForegroundApp(AppRecord *app)
+{
+    HWND hWnd = GetForegroundWindow();
+    if (hWnd == NULL)
+        return false;
+
+    int titleLength = GetWindowTextLength(hWnd);
+    std::wstring title(titleLength + 1, L'\0');
+    titleLength = GetWindowTextW(hWnd, &title[0], titleLength + 1);
+
+    app->path = getWindowProcessPath(hWnd, &this->processCache);
+    utf16ToUtf8(reinterpret_cast<const char16_t *>(title.data()), titleLength, &app->title);
+    app->isActive = true;
+    return true;
+}
+
+UINT WindowsCaptureSource::getDurationSinceLastInput()
+{
+    LASTINPUTINFO lastInput;
+    lastInput.cbSize = sizeof(lastInput);
+    GetLastInputInfo(&lastInput);
+    return (GetTickCount() - lastInput.dwTime) / 1000;
+}
+
+static BOOL CALLBACK enumWindowCallback(HWND hWnd, LPARAM lparam)
+{
+    struct CallbackParams *callbackParams = reinterpret_cast<CallbackParams *>(lparam);
+    auto *apps = callbackParams->pApps;
+    HWND activeWindow = callbackParams->activeWindow;
+
+    int titleLength = GetWindowTextLength(hWnd);
+    auto &titleBuffer = callbackParams->titleBuffer;
+    if (titleBuffer.size() < static_cast<size_t>(titleLength) + 1)
+        titleBuffer.resize(titleLength + 1);
+    wchar_t *bufferTitle = titleBuffer.data();
+    int copiedLength = GetWindowTextW(hWnd, bufferTitle, titleLength + 1);
+
+    LONG exStyles = GetWindowLongW(hWnd, GWL_EXSTYLE);
+    LONG styles = GetWindowLongW(hWnd, GWL_STYLE);
+    bool isActive = hWnd == activeWindow;
+
+    if ((IsWindowVisible(hWnd) && titleLength != 0) || isActive)
+    {
+        AppRecord &appRecord = apps->emplace_back();
+        appRecord.path = getWindowProcessPath(hWnd, callbackParams->processCache);
+        utf16ToUtf8(reinterpret_cast<const char16_t *>(bufferTitle), copiedLength, &appRecord.title);
+        appRecord.isActive = isActive;
+    }
+    return TRUE;
+}
+
+/// @brief Get the executable path of the process owning the window.
+///        The path is only queried once per process, as long as the process lives.
+/// @return UTF-8 path, or an empty string if the process cannot be opened.
+///         It is owned by the cache, and valid until the capture ends.
+const std::string &getWindowProcessPath(HWND hWnd, ProcessCache *processCache)
+{
+    DWORD pId;
+    HANDLE processHandle = NULL;
+    WCHAR processPath[MAX_PATH];
+
+    GetWindowThreadProcessId(hWnd, &pId);
+
+    // Most windows belong to a handful of processes, which only need
+    // to be opened once per capture. Focus probes between captures
+    // always check the start time, as the process may have exited since.
+    const std::string *cachedPath = processCache->findSeen(pId);
+    if (cachedPath != nullptr)
+        return *cachedPath;
+
+    processHandle = OpenProcess(PROCESS_QUERY_INFORMATION | PROCESS_VM_READ, FALSE, pId);
+    if (processHandle == NULL)
+        return processCache->insert(pId, 0, "");
+
+    FILETIME creationTime, exitTime, kernelTime, userTime;
+    unsigned long long startTime = 0;
+    if (GetProcessTimes(processHandle, &creationTime, &exitTime, &kernelTime, &userTime))
+        startTime = (static_cast<unsigned long long>(creationTime.dwHighDateTime) << 32) |
+                    creationTime.dwLowDateTime;
+
+    cachedPath = processCache->find(pId, startTime);
+    if (cachedPath != nullptr)
+    {
+        CloseHandle(processHandle);
+        return *cachedPath;
+    }
+
+    auto n = GetModuleFileNameExW(processHandle, NULL, processPath, MAX_PATH);
+    CloseHandle(processHandle);
+    if (n == 0)
+        return processCache->insert(pId, startTime, "");
+
+    return processCache->insert(pId, startTime, toUtf8(processPath));
+}
@@ -0,0 +1,21 @@
+#ifndef MAIN_CAPTURER_WIN32
+#define MAIN_CAPTURER_WIN32
+#include <memory_resource>
+#include <vector>
+
+#include "capturer.h"
+#include "process-cache.h"
+
+/// @brief Captures top-level windows with the Win32 API.
+class WindowsCaptureSource : public CaptureSource
+{
+private:
+    ProcessCache processCache;
+
+public:
+    void getOpenedApps(std::pmr::vector<AppRecord> *apps) override;
+    bool getForegroundApp(AppRecord *app) override;
+    unsigned int getDurationSinceLastInput() override;
+};
+
+#endif /* MAIN_CAPTURER_WIN32 */
@@ -1,81 +1,38 @@
-#include <Windows.h>
-#include <psapi.h>
+#include <stdexcept>
 #include <string>
-#include <vector>
 
+#include "capturer-replay.h"
 #include "capturer.h"
+#include "config.h"
+#include "dev-logger.h"
 #include "helpers.h"
 
-static BOOL CALLBACK enumWindowCallback(HWND hWnd, LPARAM lparam);
-std::wstring getWindowProcessPath(HWND hWnd);
+#ifdef _WIN32
+#include "capturer-win32.h"
+#else
+#include "capturer-linux.h"
+#endif
 
-struct CallbackParams
+CaptureSource *createCaptureSource(Config *config)
 {
-    std::vector<AppRecord> *pApps;
-    HWND activeWindow;
-};
+    const std::string &source = config->capture.source;
+    INFO("Use `{}` capture source", source);
 
-void getOpenedApps(std::vector<AppRecord> *apps)
-{
-    struct CallbackParams lparam;
-    lparam.pApps = apps;
-    lparam.activeWindow = GetForegroundWindow();
-    EnumWindows(enumWindowCallback, reinterpret_cast<LPARAM>(&lparam));
-}
-
-/// @brief Gets the duration (in seconds) since last user input.
-UINT getDurationSinceLastInput()
-{
-    LASTINPUTINFO lastInput;
-    lastInput.cbSize = sizeof(lastInput);
-    GetLastInputInfo(&lastInput);
-    return (GetTickCount() - lastInput.dwTime) / 1000;
-}
-
-static BOOL CALLBACK enumWindowCallback(HWND hWnd, LPARAM lparam)
-{
-    struct CallbackParams *callbackParams = reinterpret_cast<CallbackParams *>(lparam);
-    auto *apps = callbackParams->pApps;
-    HWND activeWindow = callbackParams->activeWindow;
-
-    int titleLength = GetWindowTextLength(hWnd);
-    wchar_t *bufferTitle = new wchar_t[titleLength + 1];
-    GetWindowTextW(hWnd, bufferTitle, titleLength + 1);
-    std::wstring title(bufferTitle);
-    delete[] bufferTitle;
-
-    LONG exStyles = GetWindowLongW(hWnd, GWL_EXSTYLE);
-    LONG styles = GetWindowLongW(hWnd, GWL_STYLE);
-    bool isActive = hWnd == activeWindow;
-
-    if ((IsWindowVisible(hWnd) && titleLength != 0) || isActive)
+    if (source == "replay")
     {
-        AppRecord appRecord;
-        appRecord.path = toUtf8(getWindowProcessPath(hWnd));
-        appRecord.title = toUtf8(title);
-        appRecord.isActive = isActive;
-        apps->push_back(appRecord);
+        std::string replayPath = config->capture.replayPath;
+        if (!replayPath.empty())
+            replayPath = prepareAndProcessPath(replayPath, false).u8string();
+        return new ReplayCaptureSource(replayPath, config->capture.syntheticApps);
     }
-    return TRUE;
-}
-
-std::wstring getWindowProcessPath(HWND hWnd)
-{
-    DWORD pId;
-    HANDLE processHandle = NULL;
-    WCHAR processPath[MAX_PATH];
 
-    GetWindowThreadProcessId(hWnd, &pId);
-    processHandle = OpenProcess(PROCESS_QUERY_INFORMATION | PROCESS_VM_READ, FALSE, pId);
-    if (processHandle != NULL)
-    {
-        auto n = GetModuleFileNameExW(processHandle, NULL, processPath, MAX_PATH);
-        CloseHandle(processHandle);
-        if (n == 0)
-            return L"";
-    }
-    else
-        return L"";
+#ifdef _WIN32
+    if (source == "auto" || source == "windows")
+        return new WindowsCaptureSource();
+#else
+    if (source == "auto" || source == "proc")
+        return new ProcCaptureSource();
+#endif
 
-    return processPath;
-}
\ No newline at end of file
+    throw std::invalid_argument("Capture source `" + source + "` is not available on this platform");
+}
@@ -1,24 +1,86 @@
 #ifndef MAIN_CAPTURER
 #define MAIN_CAPTURER
 
+#include <memory_resource>
 #include <string>
+#include <time.h>
+#include <utility>
 #include <vector>
 
+#include "config.h"
+
+/// @brief An opened app. It is allocator-aware, so the strings of
+///        the records in a `std::pmr::vector` live in the vector's arena.
 struct AppRecord
 {
-    std::string path;
-    std::string title;
+    using allocator_type = std::pmr::polymorphic_allocator<char>;
+
+    std::pmr::string path;
+    std::pmr::string title;
     bool isActive = false;
+
+    AppRecord(const allocator_type &alloc = {}) : path(alloc), title(alloc){};
+    AppRecord(const AppRecord &other, const allocator_type &alloc = {})
+        : path(other.path, alloc), title(other.title, alloc), isActive(other.isActive){};
+    AppRecord(AppRecord &&other, const allocator_type &alloc)
+        : path(std::move(other.path), alloc),
+          title(std::move(other.title), alloc),
+          isActive(other.isActive){};
+    AppRecord(AppRecord &&other) = default;
+    AppRecord &operator=(const AppRecord &other) = default;
+    AppRecord &operator=(AppRecord &&other) = default;
 };
 
+enum LogEntryType
+{
+    /// @brief Every opened app, `{"apps":[...],"time":...}`
+    LogEntrySnapshot,
+    /// @brief The user is away, `{"durationSinceLastInput":...,"timestamp":...}`
+    LogEntryIdle,
+    /// @brief Only the app in focus, `{"focus":{...},"time":...}`
+    LogEntryFocus
+};
+
+/// @brief A captured log entry, before it is serialized.
+///        Like `AppRecord`, it is allocator-aware.
 struct LogEntry
 {
-    std::vector<AppRecord> apps;
-    int activeApp;
+    using allocator_type = std::pmr::polymorphic_allocator<char>;
+
+    LogEntryType type = LogEntrySnapshot;
+    /// @brief UNIX timestamp of the capture
+    time_t timestamp = 0;
+    /// @brief Opened apps of a `LogEntrySnapshot`
+    std::pmr::vector<AppRecord> apps;
+    /// @brief App in focus of a `LogEntryFocus`
+    AppRecord focus;
+    /// @brief Seconds since last input of a `LogEntryIdle`
+    unsigned int durationSinceLastInput = 0;
+
+    LogEntry(const allocator_type &alloc = {}) : apps(alloc), focus(alloc){};
 };
 
-void getOpenedApps(std::vector<AppRecord> *apps);
+/// @brief Backend that snapshots the opened apps and the user's activity.
+class CaptureSource
+{
+public:
+    virtual ~CaptureSource(){};
+
+    /// @brief Enumerate every opened app. This is the expensive capture.
+    /// @param apps Where the apps will be put. Temporary buffers are
+    ///             allocated from the same memory resource.
+    virtual void getOpenedApps(std::pmr::vector<AppRecord> *apps) = 0;
+
+    /// @brief Cheaply probe the app the user is currently using.
+    /// @param app Where the foreground app will be put.
+    /// @return `false` if no app is in the foreground.
+    virtual bool getForegroundApp(AppRecord *app) = 0;
+
+    /// @brief Gets the duration (in seconds) since last user input.
+    virtual unsigned int getDurationSinceLastInput() = 0;
+};
 
-unsigned int getDurationSinceLastInput();
+/// @brief Create the capture source for the current platform.
+CaptureSource *createCaptureSource(Config *config);
 
 #endif /* MAIN_CAPTURER */
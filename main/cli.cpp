@@ -0,0 +1,122 @@
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "dev-logger.h"
+#include "spdlog/sinks/stdout_sinks.h"
+#include "spdlog/spdlog.h"
+
+#include "cli.h"
+#include "config.h"
+#include "crypto.h"
+#include "json.hpp"
+
+void cli::initDevLogger(const std::string &name, bool verbose)
+{
+    auto logger = spdlog::stderr_logger_mt(name);
+    spdlog::set_default_logger(logger);
+    logger->set_level(verbose ? (DEBUG_BUILD ? spdlog::level::debug : spdlog::level::info)
+                              : spdlog::level::warn);
+    logger->set_pattern("[%Y-%m-%d %T] [%l] %v");
+}
+
+long cli::parseNumber(const std::string &option, const std::string &value)
+{
+    char *end = nullptr;
+    errno = 0;
+    long number = std::strtol(value.c_str(), &end, 10);
+    if (value.empty() || *end != '\0' || errno != 0 || number < 0)
+        throw UsageError("`" + option + "` expects a non-negative number, got `" + value + "`");
+    return number;
+}
+
+Config cli::loadConfigFile(const std::filesystem::path &path)
+{
+    std::ifstream f(path);
+    if (!f)
+        throw std::runtime_error("Cannot open config file `" + path.u8string() + "`");
+
+    Config config;
+    // Initialize the json object with the default values.
+    nlohmann::json configJ = config;
+    configJ.merge_patch(nlohmann::json::parse(f));
+    configJ.get_to(config);
+
+    auto dir = std::filesystem::absolute(path).parent_path();
+    for (auto p : {&config.encryption.rsaPrivateKeyPath,
+                   &config.encryption.saltPath,
+                   &config.decryption.keyCachePath})
+        if (!p->empty() && std::filesystem::path(*p).is_relative())
+            *p = (dir / *p).u8string();
+    return config;
+}
+
+/// @brief Read the first line from a file descriptor, without the line break.
+static std::string readLine(int fd)
+{
+    std::string line;
+    char c;
+    while (line.size() < PASSWORD_MAX_LEN)
+    {
+#ifdef _WIN32
+        int n = _read(fd, &c, 1);
+#else
+        ssize_t n = read(fd, &c, 1);
+        if (n < 0 && errno == EINTR)
+            continue;
+#endif
+        if (n < 0)
+            throw std::runtime_error("Cannot read password: " + std::string(std::strerror(errno)));
+        if (n == 0 || c == '\n')
+            break;
+        line += c;
+    }
+    return line;
+}
+
+std::string cli::readPassword(int fd, const std::string &path)
+{
+    std::string password;
+    if (fd >= 0)
+        password = readLine(fd);
+    else
+    {
+        std::ifstream f(path, std::ios::binary);
+        if (!f)
+            throw std::runtime_error("Cannot open password file `" + path + "`");
+        std::getline(f, password);
+    }
+
+    if (!password.empty() && password.back() == '\r')
+        password.pop_back();
+    if (password.empty())
+        throw std::runtime_error("The password is empty");
+    return password;
+}
+
+crypto::SymKeyPasswordBased *cli::loadPrivateKey(const std::string &password,
+                                                 const std::filesystem::path &privateKeyPath,
+                                                 const std::filesystem::path &saltPath,
+                                                 crypto::AsymKey *asymKey)
+{
+    INFO("Generate symmetric key from user's password");
+    std::unique_ptr<crypto::SymKeyPasswordBased> symKey(
+        new crypto::SymKeyPasswordBased(password, saltPath.u8string()));
+
+    INFO("Load RSA private key from `{}`", privateKeyPath.u8string());
+    asymKey->loadFromFile(crypto::KeyTypePrivate, privateKeyPath.u8string(), symKey.get());
+    if (!asymKey->validate(crypto::KeyTypePrivate))
+        throw std::runtime_error("Loaded RSA private key `" + privateKeyPath.u8string() + "` is invalid");
+    return symKey.release();
+}
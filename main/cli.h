@@ -0,0 +1,57 @@
+#ifndef MAIN_CLI
+#define MAIN_CLI
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+
+#include "config.h"
+#include "crypto.h"
+
+/// Exit code of a command-line tool that did everything it was asked to.
+#define EXIT_DONE 0
+/// Exit code of a command-line tool that ran into problems with some files.
+#define EXIT_PARTIALLY_DONE 1
+/// Exit code of a command-line tool that could do nothing (bad arguments, wrong password, ...).
+#define EXIT_UNUSABLE 2
+
+/// Longest accepted password (in bytes).
+#define PASSWORD_MAX_LEN 4096
+
+/// Helpers shared by the command-line tools.
+namespace cli
+{
+    /// @brief Thrown on unusable command line arguments.
+    class UsageError : public std::runtime_error
+    {
+    public:
+        UsageError(const std::string &message) : std::runtime_error(message){};
+    };
+
+    /// @brief Log to stderr, keeping stdout for the tool's output.
+    /// @param verbose Log what is being done, not only warnings and errors.
+    void initDevLogger(const std::string &name, bool verbose);
+
+    /// @brief Parse the non-negative number given to a command line option.
+    ///        Throws `UsageError` if it is not one.
+    long parseNumber(const std::string &option, const std::string &value);
+
+    /// @brief Load a config file, relative paths in it being relative to the file.
+    Config loadConfigFile(const std::filesystem::path &path);
+
+    /// @brief Read the first line of a file descriptor or a file,
+    ///        without the line break. Throws if it is empty.
+    /// @param fd File descriptor to read from, `-1` to read `path` instead.
+    std::string readPassword(int fd, const std::string &path);
+
+    /// @brief Load the password-protected RSA private key.
+    ///        Throws `crypto::DecryptionError` if the password is wrong,
+    ///        and `std::runtime_error` if the key is invalid.
+    /// @param asymKey Where the private key will be put.
+    /// @return Key derived from the password, to be deleted by the caller.
+    crypto::SymKeyPasswordBased *loadPrivateKey(const std::string &password,
+                                                const std::filesystem::path &privateKeyPath,
+                                                const std::filesystem::path &saltPath,
+                                                crypto::AsymKey *asymKey);
+}
+
+#endif /* MAIN_CLI */
@@ -0,0 +1,71 @@
+#include <algorithm>
+#include <string>
+
+#include <cryptopp/cryptlib.h>
+#include <cryptopp/filters.h>
+#include <cryptopp/zdeflate.h>
+#include <cryptopp/zinflate.h>
+
+#include "compression.h"
+#include "dev-logger.h"
+
+/// Length (in bytes) of the compressed data inflated at a time,
+/// before checking the length of the output.
+#define INFLATE_CHUNK_LEN 16384
+
+logger::Compressor::Compressor(int level)
+{
+    using namespace CryptoPP;
+    level = std::min(std::max(level, DEFLATE_MIN_LEVEL), DEFLATE_MAX_LEVEL);
+    this->deflator = new Deflator(new StringSink(this->output), level);
+}
+
+logger::Compressor::~Compressor()
+{
+    delete this->deflator;
+}
+
+const std::string &logger::Compressor::compress(const unsigned char *data, size_t dataLen)
+{
+    // The Deflator resets itself at the end of every message,
+    // and the sink appends to the cleared output.
+    this->output.clear();
+    this->deflator->Put(data, dataLen);
+    this->deflator->MessageEnd();
+    return this->output;
+}
+
+void logger::deflateData(const unsigned char *data, size_t dataLen, int level, std::string *output)
+{
+    using namespace CryptoPP;
+    level = std::min(std::max(level, DEFLATE_MIN_LEVEL), DEFLATE_MAX_LEVEL);
+
+    output->clear();
+    Deflator deflator(new StringSink(*output), level);
+    deflator.Put(data, dataLen);
+    deflator.MessageEnd();
+}
+
+bool logger::inflateData(const unsigned char *data, size_t dataLen, size_t maxLen, std::string *output)
+{
+    using namespace CryptoPP;
+    output->clear();
+
+    try
+    {
+        Inflator inflator(new StringSink(*output));
+        for (size_t offset = 0; offset < dataLen; offset += INFLATE_CHUNK_LEN)
+        {
+            inflator.Put(data + offset, std::min<size_t>(INFLATE_CHUNK_LEN, dataLen - offset));
+            if (output->size() > maxLen)
+                return false;
+        }
+        inflator.MessageEnd();
+    }
+    catch (const CryptoPP::Exception &ex)
+    {
+        DEBUG("Cannot inflate data: {}", ex.what());
+        return false;
+    }
+    return output->size() <= maxLen;
+}
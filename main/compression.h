@@ -0,0 +1,55 @@
+#ifndef MAIN_COMPRESSION
+#define MAIN_COMPRESSION
+#include <string>
+
+/// Lowest Deflate level (fastest, largest output).
+#define DEFLATE_MIN_LEVEL 1
+/// Highest Deflate level (slowest, smallest output).
+#define DEFLATE_MAX_LEVEL 9
+
+namespace CryptoPP
+{
+    class Deflator;
+}
+
+namespace logger
+{
+    /// @brief Raw Deflate compressor reused for many messages. Its Deflator
+    ///        (window and hash tables) is built once and reset after every
+    ///        message, and its output keeps its capacity, so compressing an
+    ///        entry does not allocate once the buffers have grown.
+    class Compressor
+    {
+    private:
+        std::string output;
+        CryptoPP::Deflator *deflator = nullptr;
+
+    public:
+        /// @param level Deflate level, from `DEFLATE_MIN_LEVEL` to `DEFLATE_MAX_LEVEL`.
+        Compressor(int level);
+        Compressor(const Compressor &) = delete;
+        Compressor &operator=(const Compressor &) = delete;
+        ~Compressor();
+
+        /// @brief Compress data as a message of its own, which `inflateData` decompresses.
+        /// @return The compressed data, valid until the next call.
+        const std::string &compress(const unsigned char *data, size_t dataLen);
+    };
+
+    /// @brief Compress data with raw Deflate, with a Deflator of its own.
+    ///        Prefer a `Compressor` to compress many messages.
+    /// @param level Deflate level, from `DEFLATE_MIN_LEVEL` to `DEFLATE_MAX_LEVEL`.
+    /// @param output Where the compressed data will be put, replacing its content.
+    ///               Its capacity is kept, so reusing it avoids allocations.
+    void deflateData(const unsigned char *data, size_t dataLen, int level, std::string *output);
+
+    /// @brief Decompress what `deflateData` gave.
+    /// @param maxLen Most bytes the data may decompress to, so a forged
+    ///               frame cannot make it fill the memory.
+    /// @param output Where the decompressed data will be put, replacing its content.
+    /// @return `false` if the data is not valid Deflate, or decompresses
+    ///         to more than `maxLen` bytes.
+    bool inflateData(const unsigned char *data, size_t dataLen, size_t maxLen, std::string *output);
+}
+
+#endif /* MAIN_COMPRESSION */
@@ -59,6 +59,8 @@ void to_json(nlohmann::json &j, const Config &c)
     j = nlohmann::json{
         {"outDir", c.outDir},
         {"loggingInterval", c.loggingInterval},
+        {"focusProbeInterval", c.focusProbeInterval},
+        {"missedTicks", c.missedTicks},
         {"idleThreshold", c.idleThreshold},
     };
     j["encryption"] = nlohmann::json{
@@ -66,17 +68,54 @@ void to_json(nlohmann::json &j, const Config &c)
         {"rsaPublicKeyPath", c.encryption.rsaPublicKeyPath},
         {"rsaPrivateKeyPath", c.encryption.rsaPrivateKeyPath},
         {"saltPath", c.encryption.saltPath},
-        {"keyGenRate", c.encryption.keyGenRate}};
+        {"keyGenRate", c.encryption.keyGenRate},
+        {"compressionLevel", c.encryption.compressionLevel}};
+    j["flush"] = nlohmann::json{
+        {"policy", c.flush.policy},
+        {"entries", c.flush.entries},
+        {"interval", c.flush.interval},
+        {"syncInterval", c.flush.syncInterval}};
+    j["batch"] = nlohmann::json{
+        {"entries", c.batch.entries},
+        {"bytes", c.batch.bytes},
+        {"maxAge", c.batch.maxAge}};
+    j["queue"] = nlohmann::json{
+        {"capacity", c.queue.capacity},
+        {"overflow", c.queue.overflow}};
+    j["capture"] = nlohmann::json{
+        {"source", c.capture.source},
+        {"replayPath", c.capture.replayPath},
+        {"syntheticApps", c.capture.syntheticApps}};
+    j["decryption"] = nlohmann::json{
+        {"threads", c.decryption.threads},
+        {"keyCachePath", c.decryption.keyCachePath}};
 };
 
 void from_json(const nlohmann::json &j, Config &c)
 {
     j.at("outDir").get_to(c.outDir);
     j.at("loggingInterval").get_to(c.loggingInterval);
+    j.at("focusProbeInterval").get_to(c.focusProbeInterval);
+    j.at("missedTicks").get_to(c.missedTicks);
     j.at("idleThreshold").get_to(c.idleThreshold);
     j.at("encryption").at("enabled").get_to(c.encryption.enabled);
     j.at("encryption").at("rsaPublicKeyPath").get_to(c.encryption.rsaPublicKeyPath);
     j.at("encryption").at("rsaPrivateKeyPath").get_to(c.encryption.rsaPrivateKeyPath);
     j.at("encryption").at("saltPath").get_to(c.encryption.saltPath);
     j.at("encryption").at("keyGenRate").get_to(c.encryption.keyGenRate);
+    j.at("encryption").at("compressionLevel").get_to(c.encryption.compressionLevel);
+    j.at("flush").at("policy").get_to(c.flush.policy);
+    j.at("flush").at("entries").get_to(c.flush.entries);
+    j.at("flush").at("interval").get_to(c.flush.interval);
+    j.at("flush").at("syncInterval").get_to(c.flush.syncInterval);
+    j.at("batch").at("entries").get_to(c.batch.entries);
+    j.at("batch").at("bytes").get_to(c.batch.bytes);
+    j.at("batch").at("maxAge").get_to(c.batch.maxAge);
+    j.at("queue").at("capacity").get_to(c.queue.capacity);
+    j.at("queue").at("overflow").get_to(c.queue.overflow);
+    j.at("capture").at("source").get_to(c.capture.source);
+    j.at("capture").at("replayPath").get_to(c.capture.replayPath);
+    j.at("capture").at("syntheticApps").get_to(c.capture.syntheticApps);
+    j.at("decryption").at("threads").get_to(c.decryption.threads);
+    j.at("decryption").at("keyCachePath").get_to(c.decryption.keyCachePath);
 };
\ No newline at end of file
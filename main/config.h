@@ -10,19 +10,92 @@ struct EncryptionConfig
     std::string saltPath = "./crypto/main.salt.data";
     // How often to generate a new AES key for log encryption.
     // In the units of `number of key generations per log entries`.
+    // Each log file gets one RSA-wrapped key, the following keys
+    // are derived from it, so rotating often is cheap.
     unsigned int keyGenRate = 60;
+    // Deflate level (1 to 9) entries are compressed with before being
+    // encrypted, as encrypted entries cannot be compressed. `0` disables it.
+    unsigned int compressionLevel = 0;
     bool enabled = false;
 };
 
+struct FlushConfig
+{
+    // When to hand buffered log entries to the operating system.
+    // One of `"entry"` (after every entry), `"count"` (every `entries` entries)
+    // or `"interval"` (every `interval` seconds).
+    std::string policy = "entry";
+    unsigned int entries = 10;
+    unsigned int interval = 300;
+    // Least number of seconds between asking the operating system to put
+    // flushed entries on the disk (fsync), so they survive a power loss.
+    // `0` leaves it to the operating system.
+    unsigned int syncInterval = 0;
+};
+
+struct BatchConfig
+{
+    // Most entries encrypted together into a single frame of an encrypted log file.
+    // `1` encrypts every entry on its own, as soon as it is captured.
+    unsigned int entries = 1;
+    // A batch is written once the text of its entries reaches this many bytes.
+    unsigned int bytes = 65536;
+    // Most seconds an entry waits in a batch before being written,
+    // which bounds how many entries a crash can lose.
+    unsigned int maxAge = 300;
+};
+
+struct QueueConfig
+{
+    // Maximum number of captured entries waiting to be written.
+    unsigned int capacity = 64;
+    // What to do with a new entry when the queue is full.
+    // Either `"block"` (wait for the writer) or `"drop"` (discard the entry).
+    std::string overflow = "block";
+};
+
+struct CaptureConfig
+{
+    // Where snapshots come from. `"auto"` picks the platform's native source.
+    // Other sources are `"windows"`, `"proc"` (Linux `/proc`) and `"replay"`.
+    std::string source = "auto";
+    // Plain JSON log file the `"replay"` source plays back.
+    // When empty, synthetic snapshots are generated instead.
+    std::string replayPath = "";
+    // Number of apps in each synthetic snapshot.
+    unsigned int syntheticApps = 20;
+};
+
+struct DecryptionConfig
+{
+    // Number of threads decrypting log files. `0` uses one per hardware thread.
+    unsigned int threads = 0;
+    // Where unwrapped AES keys are kept between runs, encrypted with
+    // the private key password. When empty, they are only kept in memory.
+    std::string keyCachePath = "";
+};
+
 struct Config
 {
     std::string outDir = "./owl-logs";
-    unsigned int loggingInterval = 60;
+    // How many seconds between captures. Can be a fraction of a second.
+    double loggingInterval = 60;
+    // How many seconds between cheap probes of the app in focus,
+    // which run in between full captures. `0` disables focus probes.
+    double focusProbeInterval = 0;
+    // What to do when captures fall behind by more than an interval.
+    // Either `"skip"` the missed captures, or `"catchUp"` on all of them.
+    std::string missedTicks = "skip";
     // How many seconds to consider the user as idle
     // and temporarily stop logging until the user is
     // active again.
     unsigned int idleThreshold = 60;
     EncryptionConfig encryption;
+    FlushConfig flush;
+    BatchConfig batch;
+    QueueConfig queue;
+    CaptureConfig capture;
+    DecryptionConfig decryption;
 };
 
 Config loadConfig(bool createIfMissing = 0);
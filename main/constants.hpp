@@ -8,7 +8,11 @@
 
 namespace constants
 {
+#ifdef _WIN32
     const std::string PERPETUAL_EXE_FILENAME = std::string(PERPETUAL_TARGET_NAME) + u8".exe";
+#else
+    const std::string PERPETUAL_EXE_FILENAME = std::string(PERPETUAL_TARGET_NAME);
+#endif
     const std::filesystem::path LOG_OUTPUT_DIR = std::filesystem::weakly_canonical(
         getExecutableDirPath() /
         std::filesystem::path("./dev-logs/"));
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <filesystem>
 #include <memory>
 #include <stdexcept>
@@ -8,6 +9,8 @@
 #include <cryptopp/ccm.h>
 #include <cryptopp/cryptlib.h>
 #include <cryptopp/files.h>
+#include <cryptopp/gcm.h>
+#include <cryptopp/hkdf.h>
 #include <cryptopp/osrng.h>
 #include <cryptopp/pwdbased.h>
 #include <cryptopp/rsa.h>
@@ -18,14 +21,70 @@
 /// AES key length in bytes
 #define AES_KEY_LEN 16
 #define AES_BLOCKSIZE CryptoPP::AES::BLOCKSIZE
+/// Length (in bytes) of an AES-GCM nonce.
+#define GCM_NONCE_LEN 12
+/// Length (in bytes) of an AES-GCM authentication tag.
+#define GCM_TAG_LEN 16
+/// HKDF info segment keys are derived with, followed by the segment number.
+#define SEGMENT_KEY_INFO "watchful-owl segment key"
 /// Salt length in bytes
 #define SALT_LEN 32
 #define PBKDF2_ITERATIONS 600000
 
+typedef CryptoPP::RSAES<CryptoPP::OAEP<CryptoPP::SHA256>> RsaScheme;
+
+struct crypto::SymKeyContexts
+{
+    // Each is keyed on first use: an AES-GCM key schedule
+    // also precomputes tables, so it is not done needlessly.
+    std::unique_ptr<CryptoPP::CBC_Mode<CryptoPP::AES>::Encryption> cbcEncryption;
+    std::unique_ptr<CryptoPP::CBC_Mode<CryptoPP::AES>::Decryption> cbcDecryption;
+    std::unique_ptr<CryptoPP::GCM<CryptoPP::AES>::Encryption> gcmEncryption;
+    std::unique_ptr<CryptoPP::GCM<CryptoPP::AES>::Decryption> gcmDecryption;
+};
+
+struct crypto::AsymKeyContexts
+{
+    std::unique_ptr<RsaScheme::Encryptor> encryptor;
+    std::unique_ptr<RsaScheme::Decryptor> decryptor;
+};
+
+/// @brief Random number generator of the calling thread,
+///        seeded from the OS once rather than on every use.
+static CryptoPP::RandomNumberGenerator &getRng()
+{
+    thread_local CryptoPP::AutoSeededRandomPool rng;
+    return rng;
+}
+
+/// @brief Create and key a cipher object, unless it already is.
+///        It is keyed with a zero IV, to be resynchronized before use.
+template <class Cipher>
+static Cipher *getKeyed(std::unique_ptr<Cipher> &cipher,
+                        const CryptoPP::byte *secret, size_t secretLen, size_t ivLen)
+{
+    if (!cipher)
+    {
+        CryptoPP::SecByteBlock iv(ivLen);
+        std::fill(iv.begin(), iv.end(), 0);
+        cipher.reset(new Cipher);
+        cipher->SetKeyWithIV(secret, secretLen, iv, iv.size());
+    }
+    return cipher.get();
+}
+
 crypto::AsymKey::~AsymKey()
 {
     delete this->privateKey;
     delete this->publicKey;
+    delete this->contexts;
+}
+
+crypto::AsymKeyContexts *crypto::AsymKey::getContexts()
+{
+    if (this->contexts == nullptr)
+        this->contexts = new AsymKeyContexts();
+    return this->contexts;
 }
 
 void crypto::AsymKey::generate(unsigned int size)
@@ -34,26 +93,25 @@ void crypto::AsymKey::generate(unsigned int size)
     if (this->publicKey != nullptr || this->privateKey != nullptr)
         throw CryptoError("Cannot generate new key on an already populated RsaKey");
 
-    AutoSeededRandomPool rng;
     this->privateKey = new RSA::PrivateKey();
     spdlog::stopwatch sw;
     INFO("Generate private key with size of {} bits", size);
-    privateKey->GenerateRandomWithKeySize(rng, size);
+    privateKey->GenerateRandomWithKeySize(getRng(), size);
 
     INFO("Generate public key from private key");
     this->publicKey = new RSA::PublicKey(*privateKey);
     INFO("Time taken to generate RSA key pair: `{:.3} seconds`", sw);
+
+    this->getContexts()->encryptor.reset(new RsaScheme::Encryptor(*this->publicKey));
+    this->getContexts()->decryptor.reset(new RsaScheme::Decryptor(*this->privateKey));
 }
 
 void crypto::AsymKey::encrypt(
     CryptoPP::byte *plain, size_t plainLen,
     CryptoPP::byte *cipher, size_t cipherLen)
 {
-    using namespace CryptoPP;
     assert(this->publicKey != nullptr);
-
-    AutoSeededRandomPool prng;
-    RSAES<OAEP<SHA256>>::Encryptor encryptor(*this->publicKey);
+    const RsaScheme::Encryptor &encryptor = *this->getContexts()->encryptor;
 
     assert(0 != encryptor.FixedMaxPlaintextLength());
     assert(plainLen <= encryptor.FixedMaxPlaintextLength());
@@ -61,24 +119,22 @@ void crypto::AsymKey::encrypt(
     size_t actualCipherLen = encryptor.CiphertextLength(plainLen);
     assert(cipherLen >= actualCipherLen);
 
-    encryptor.Encrypt(prng, plain, plainLen, cipher);
+    encryptor.Encrypt(getRng(), plain, plainLen, cipher);
 }
 
-void crypto::AsymKey::decrypt(CryptoPP::byte *cipher, size_t cipherLen,
+void crypto::AsymKey::decrypt(const CryptoPP::byte *cipher, size_t cipherLen,
                               CryptoPP::byte *plain, size_t plainLen,
                               size_t *outputLen)
 {
     using namespace CryptoPP;
     assert(this->privateKey != nullptr);
-
-    AutoSeededRandomPool prng;
-    RSAES<OAEP<SHA256>>::Decryptor decryptor(*this->privateKey);
+    const RsaScheme::Decryptor &decryptor = *this->getContexts()->decryptor;
 
     assert(0 != decryptor.FixedCiphertextLength());
     assert(cipherLen <= decryptor.FixedCiphertextLength());
     assert(plainLen >= decryptor.MaxPlaintextLength(cipherLen));
 
-    DecodingResult result = decryptor.Decrypt(prng, cipher, cipherLen, plain);
+    DecodingResult result = decryptor.Decrypt(getRng(), cipher, cipherLen, plain);
     if (!result.isValidCoding)
         throw DecryptionError("AsymKey::decrypt: Decryption result is not a valid coding.");
 
@@ -138,39 +194,38 @@ void crypto::AsymKey::loadFromFile(crypto::KeyType keyType, std::string path, cr
         assert(this->privateKey == nullptr);
         this->privateKey = new RSA::PrivateKey;
         this->privateKey->Load(*(q.get()));
+        this->getContexts()->decryptor.reset(new RsaScheme::Decryptor(*this->privateKey));
         return;
     };
 
     assert(this->publicKey == nullptr);
     this->publicKey = new RSA::PublicKey;
     this->publicKey->Load(*(q.get()));
+    this->getContexts()->encryptor.reset(new RsaScheme::Encryptor(*this->publicKey));
     return;
 }
 
 bool crypto::AsymKey::validate(crypto::KeyType keyType)
 {
-    CryptoPP::AutoSeededRandomPool prng;
     if (keyType == KeyTypePrivate)
     {
         if (this->privateKey == nullptr)
             throw CryptoError("Cannot validate private key as it's not loaded or generated yet.");
-        return this->privateKey->Validate(prng, 2);
+        return this->privateKey->Validate(getRng(), 2);
     };
 
     if (this->publicKey == nullptr)
         throw CryptoError("Cannot validate public key as it's not loaded or generated yet.");
-    return this->publicKey->Validate(prng, 2);
+    return this->publicKey->Validate(getRng(), 2);
 }
 
 size_t crypto::AsymKey::calculateCipherLen()
 {
-    using namespace CryptoPP;
     assert(this->publicKey != nullptr);
     if (this->cipherLen != 0)
         return this->cipherLen;
 
-    RSAES<OAEP<SHA256>>::Encryptor e(*this->publicKey);
-    this->cipherLen = e.FixedCiphertextLength();
+    this->cipherLen = this->getContexts()->encryptor->FixedCiphertextLength();
     return this->cipherLen;
 }
 
@@ -194,12 +249,10 @@ crypto::SymKeyPasswordBased::SymKeyPasswordBased(std::string password)
 {
     using namespace CryptoPP;
     DEBUG("Generate random salt");
-    AutoSeededRandomPool prng;
-
     this->password = password;
     this->salt = new byte[SALT_LEN];
     this->saltLen = SALT_LEN;
-    prng.GenerateBlock(salt, SALT_LEN);
+    getRng().GenerateBlock(salt, SALT_LEN);
 
     this->populateSecret();
 }
@@ -272,11 +325,17 @@ void crypto::SymKey::generateRandom()
 {
     using namespace CryptoPP;
     assert(this->secret == nullptr);
-    AutoSeededRandomPool prng;
-
     this->secret = new byte[AES_KEY_LEN];
     this->secretLen = AES_KEY_LEN;
-    prng.GenerateBlock(this->secret, this->secretLen);
+    getRng().GenerateBlock(this->secret, this->secretLen);
+}
+
+crypto::SymKeyContexts *crypto::SymKey::getContexts()
+{
+    assert(this->secret != nullptr);
+    if (this->contexts == nullptr)
+        this->contexts = new SymKeyContexts();
+    return this->contexts;
 }
 crypto::SymKey::SymKey(CryptoPP::byte *secret, size_t secretLen)
 {
@@ -311,24 +370,35 @@ void crypto::SymKey::encrypt(CryptoPP::ByteQueue *plain, CryptoPP::ByteQueue *ci
 void crypto::SymKey::encrypt(
     CryptoPP::byte *plain, size_t plainLen,
     CryptoPP::byte *cipher, size_t cipherLen)
+{
+    // The IV is put at the start of the cipher, followed by the plain data.
+    assert(cipherLen >= this->calculateCipherLen(plainLen));
+    std::copy(plain, plain + plainLen, cipher + AES_BLOCKSIZE);
+    this->encryptInPlace(cipher, plainLen, cipherLen);
+};
+
+size_t crypto::SymKey::encryptInPlace(
+    CryptoPP::byte *buffer, size_t plainLen, size_t bufferLen)
 {
     using namespace CryptoPP;
-    AutoSeededRandomPool prng;
-    SecByteBlock iv(AES_BLOCKSIZE);
-    prng.GenerateBlock(iv, iv.size());
+    size_t cipherLen = this->calculateCipherLen(plainLen);
+    assert(bufferLen >= cipherLen);
 
-    CBC_Mode<AES>::Encryption e;
-    e.SetKeyWithIV(this->secret, this->secretLen, iv);
+    getRng().GenerateBlock(buffer, AES_BLOCKSIZE);
 
-    // Add IV to the start of the cipher.
-    std::copy(iv.begin(), iv.end(), cipher);
+    // PKCS #7 padding, as `StreamTransformationFilter` would add.
+    byte *plain = buffer + AES_BLOCKSIZE;
+    size_t paddedLen = cipherLen - AES_BLOCKSIZE;
+    byte padding = static_cast<byte>(paddedLen - plainLen);
+    std::fill(plain + plainLen, plain + paddedLen, padding);
 
-    ArraySource(plain, plainLen,
-                true,
-                new StreamTransformationFilter(
-                    e,
-                    new ArraySink(cipher + iv.size(), cipherLen - iv.size())));
-};
+    auto e = getKeyed(this->getContexts()->cbcEncryption,
+                      this->secret, this->secretLen, AES_BLOCKSIZE);
+    e->Resynchronize(buffer, AES_BLOCKSIZE);
+    e->ProcessData(plain, plain, paddedLen);
+
+    return cipherLen;
+}
 
 void crypto::SymKey::decrypt(CryptoPP::ByteQueue *cipher, CryptoPP::ByteQueue *plain)
 {
@@ -353,37 +423,37 @@ void crypto::SymKey::decrypt(CryptoPP::ByteQueue *cipher, CryptoPP::ByteQueue *p
     delete[] outBuffer;
 };
 void crypto::SymKey::decrypt(
-    CryptoPP::byte *cipher, size_t cipherLen,
+    const CryptoPP::byte *cipher, size_t cipherLen,
     CryptoPP::byte *plainBuffer, size_t plainBufferLen,
     size_t *outputLen)
 {
     using namespace CryptoPP;
 
-    byte iv[AES_BLOCKSIZE];
-    std::copy(cipher, cipher + AES_BLOCKSIZE, iv);
+    if (cipherLen < AES_BLOCKSIZE)
+        throw DecryptionError("SymKey::decrypt: Cipher is shorter than the IV.");
 
-    CBC_Mode<AES>::Decryption d;
-    d.SetKeyWithIV(this->secret, this->secretLen, iv);
+    size_t paddedLen = cipherLen - AES_BLOCKSIZE;
+    if (paddedLen == 0 || paddedLen % AES_BLOCKSIZE != 0)
+        throw DecryptionError("SymKey::decrypt: Cipher is not a whole number of blocks.");
+    if (plainBufferLen < paddedLen)
+        throw CryptoError("SymKey::decrypt: Plain buffer is too small for the padded plain text.");
 
-    MeterFilter meter(new ArraySink(plainBuffer, plainBufferLen));
+    auto d = getKeyed(this->getContexts()->cbcDecryption,
+                      this->secret, this->secretLen, AES_BLOCKSIZE);
+    d->Resynchronize(cipher, AES_BLOCKSIZE);
+    d->ProcessData(plainBuffer, cipher + AES_BLOCKSIZE, paddedLen);
 
-    try
-    {
-        ArraySource ar(cipher + AES_BLOCKSIZE,
-                       cipherLen - AES_BLOCKSIZE,
-                       true,
-                       new StreamTransformationFilter(
-                           d,
-                           new Redirector(meter)));
-    }
-    catch (const CryptoPP::InvalidCiphertext &ex)
-    {
-        throw DecryptionError(ex.what());
-    }
+    // Remove the PKCS #7 padding, as `StreamTransformationFilter` would.
+    byte padding = plainBuffer[paddedLen - 1];
+    bool validPadding = padding != 0 && padding <= AES_BLOCKSIZE;
+    for (size_t i = paddedLen - padding; validPadding && i < paddedLen; i++)
+        validPadding = plainBuffer[i] == padding;
+    if (!validPadding)
+        throw DecryptionError("SymKey::decrypt: Invalid PKCS #7 block padding found.");
 
     if (outputLen != nullptr)
     {
-        *outputLen = meter.GetTotalBytes();
+        *outputLen = paddedLen - padding;
     }
 };
 
@@ -398,6 +468,88 @@ size_t crypto::SymKey::getSecretLen()
     return this->secretLen;
 }
 
+size_t crypto::SymKey::getIvLen()
+{
+    return AES_BLOCKSIZE;
+}
+
+crypto::SymKey *crypto::SymKey::deriveSegmentKey(unsigned long long segment)
+{
+    using namespace CryptoPP;
+    assert(this->secret != nullptr);
+
+    // The info is the label, followed by the segment number in big-endian.
+    const size_t labelLen = sizeof(SEGMENT_KEY_INFO) - 1;
+    byte info[labelLen + 8];
+    std::copy(SEGMENT_KEY_INFO, SEGMENT_KEY_INFO + labelLen, info);
+    for (int i = labelLen + 7; i >= static_cast<int>(labelLen); i--)
+    {
+        info[i] = static_cast<byte>(segment);
+        segment >>= 8;
+    }
+
+    byte derived[AES_KEY_LEN];
+    HKDF<SHA256> hkdf;
+    hkdf.DeriveKey(derived, AES_KEY_LEN, this->secret, this->secretLen,
+                   nullptr, 0, info, sizeof(info));
+    return new SymKey(derived, AES_KEY_LEN);
+}
+
+size_t crypto::SymKey::getTagLen()
+{
+    return GCM_TAG_LEN;
+}
+
+/// @brief Derive a GCM nonce from a message counter: 4 zero bytes,
+///        then the counter in big-endian. Every key is random and
+///        only used for one run of counters, so they never collide.
+static void deriveNonce(unsigned long long counter, CryptoPP::byte *nonce)
+{
+    std::fill(nonce, nonce + GCM_NONCE_LEN, 0);
+    for (int i = GCM_NONCE_LEN - 1; i >= GCM_NONCE_LEN - 8; i--)
+    {
+        nonce[i] = static_cast<CryptoPP::byte>(counter);
+        counter >>= 8;
+    }
+}
+
+void crypto::SymKey::encryptAuthenticated(CryptoPP::byte *buffer, size_t plainLen,
+                                          unsigned long long counter,
+                                          const CryptoPP::byte *aad, size_t aadLen)
+{
+    using namespace CryptoPP;
+    byte nonce[GCM_NONCE_LEN];
+    deriveNonce(counter, nonce);
+
+    // The nonce is set anew by `EncryptAndAuthenticate`.
+    auto e = getKeyed(this->getContexts()->gcmEncryption,
+                      this->secret, this->secretLen, GCM_NONCE_LEN);
+    e->EncryptAndAuthenticate(buffer, buffer + plainLen, GCM_TAG_LEN,
+                              nonce, GCM_NONCE_LEN, aad, aadLen, buffer, plainLen);
+}
+
+size_t crypto::SymKey::decryptAuthenticated(const CryptoPP::byte *cipher, size_t cipherLen,
+                                            unsigned long long counter,
+                                            const CryptoPP::byte *aad, size_t aadLen,
+                                            CryptoPP::byte *plainBuffer, size_t plainBufferLen)
+{
+    using namespace CryptoPP;
+    if (cipherLen < GCM_TAG_LEN)
+        throw DecryptionError("SymKey::decryptAuthenticated: Cipher is shorter than the tag.");
+
+    size_t plainLen = cipherLen - GCM_TAG_LEN;
+    assert(plainBufferLen >= plainLen);
+    byte nonce[GCM_NONCE_LEN];
+    deriveNonce(counter, nonce);
+
+    auto d = getKeyed(this->getContexts()->gcmDecryption,
+                      this->secret, this->secretLen, GCM_NONCE_LEN);
+    if (!d->DecryptAndVerify(plainBuffer, cipher + plainLen, GCM_TAG_LEN,
+                             nonce, GCM_NONCE_LEN, aad, aadLen, cipher, plainLen))
+        throw DecryptionError("SymKey::decryptAuthenticated: The data does not match its tag.");
+    return plainLen;
+}
+
 size_t crypto::SymKey::calculateCipherLen(size_t plainLen)
 {
     return plainLen + (AES_BLOCKSIZE - (plainLen % AES_BLOCKSIZE)) +
@@ -408,6 +560,7 @@ size_t crypto::SymKey::calculateCipherLen(size_t plainLen)
 crypto::SymKey::~SymKey()
 {
     delete[] this->secret;
+    delete this->contexts;
 }
 
 crypto::CryptoError::CryptoError(const std::string &message) : message(message)
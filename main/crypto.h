@@ -4,11 +4,22 @@
 
 namespace crypto
 {
+    /// @brief Cipher objects keyed with a `SymKey`, defined in crypto.cpp.
+    struct SymKeyContexts;
+    /// @brief RSA encryptor and decryptor of an `AsymKey`, defined in crypto.cpp.
+    struct AsymKeyContexts;
+
+    /// @brief AES key. Its cipher objects are keyed once and reused for
+    ///        every message, so a key must not be used by two threads at once.
     class SymKey
     {
     protected:
         CryptoPP::byte *secret = nullptr;
         size_t secretLen = 0;
+        /// @brief Created on first use, once the secret is known.
+        SymKeyContexts *contexts = nullptr;
+
+        SymKeyContexts *getContexts();
 
     public:
         /// @brief Generate a symmetric key with a random secret.
@@ -23,6 +34,8 @@ namespace crypto
 
         size_t getSecretLen();
         void getSecret(CryptoPP::byte *secretBuffer, size_t secretBufferLen);
+        /// @brief Length (in bytes) of the IV prepended to every cipher.
+        size_t getIvLen();
 
         /// @brief Calculate the needed cipher length from the plain length
         ///        while accounting for the IV and padding.
@@ -32,18 +45,61 @@ namespace crypto
 
         void encrypt(CryptoPP::byte *plain, size_t plainLen, CryptoPP::byte *cipher, size_t cipherLen);
         void encrypt(CryptoPP::ByteQueue *plain, CryptoPP::ByteQueue *cipher);
+        /// @brief Encrypt without copying the plain data.
+        ///        `buffer` must hold `getIvLen()` free bytes, followed by the plain data,
+        ///        and be at least `calculateCipherLen(plainLen)` bytes long.
+        /// @param buffer Where the IV and the cipher will be put, in place of the plain data.
+        /// @param plainLen Length (in bytes) of plain data.
+        /// @param bufferLen Length (in bytes) of the buffer.
+        /// @return Length (in bytes) of cipher data.
+        size_t encryptInPlace(CryptoPP::byte *buffer, size_t plainLen, size_t bufferLen);
 
         /// @brief Decrypt cipher
         /// @param cipher
         /// @param cipherLen
         /// @param plainBuffer Where the decrypted plain text will be put.
-        /// @param plainBufferLen
+        /// @param plainBufferLen At least `cipherLen - getIvLen()`, as the padding is
+        ///                       decrypted into the buffer before being removed.
         /// @param outputLen Where the actual decrypted output length (in bytes) will be put.
         void decrypt(
-            CryptoPP::byte *cipher, size_t cipherLen,
+            const CryptoPP::byte *cipher, size_t cipherLen,
             CryptoPP::byte *plainBuffer, size_t plainBufferLen,
             size_t *outputLen = nullptr);
         void decrypt(CryptoPP::ByteQueue *cipher, CryptoPP::ByteQueue *plain);
+
+        /// @brief Derive the key of a segment of log entries from this key
+        ///        with HKDF-SHA256, the segment number being the info.
+        ///        Rotating keys that way needs no RSA operation.
+        /// @param segment Number of the segment, from 1.
+        /// @return New SymKey, owned by the caller.
+        SymKey *deriveSegmentKey(unsigned long long segment);
+
+        /// @brief Length (in bytes) of the tag `encryptAuthenticated` appends.
+        size_t getTagLen();
+
+        /// @brief Encrypt with AES-GCM in place, and append the authentication tag.
+        ///        The nonce is derived from `counter`, so no IV is stored,
+        ///        but a counter must never be used twice with the same key.
+        /// @param buffer The plain data, followed by `getTagLen()` free bytes.
+        /// @param plainLen Length (in bytes) of plain data.
+        /// @param counter Number of the message under this key.
+        /// @param aad Associated data, authenticated but not encrypted.
+        /// @param aadLen Length (in bytes) of the associated data.
+        void encryptAuthenticated(CryptoPP::byte *buffer, size_t plainLen,
+                                  unsigned long long counter,
+                                  const CryptoPP::byte *aad, size_t aadLen);
+
+        /// @brief Decrypt and verify what `encryptAuthenticated` gave.
+        ///        Throws `DecryptionError` if the cipher, the tag or the
+        ///        associated data do not match, e.g. after tampering.
+        /// @param cipher The cipher, followed by the tag.
+        /// @param plainBuffer Where the decrypted plain text will be put.
+        ///                    At least `cipherLen - getTagLen()` bytes long.
+        /// @return Length (in bytes) of the plain text.
+        size_t decryptAuthenticated(const CryptoPP::byte *cipher, size_t cipherLen,
+                                    unsigned long long counter,
+                                    const CryptoPP::byte *aad, size_t aadLen,
+                                    CryptoPP::byte *plainBuffer, size_t plainBufferLen);
     };
 
     class SymKeyPasswordBased : public SymKey
@@ -70,12 +126,18 @@ namespace crypto
         KeyTypePrivate
     };
 
+    /// @brief RSA key pair. Once generated or loaded, it is
+    ///        safe to encrypt and decrypt with from several threads.
     class AsymKey
     {
     private:
         CryptoPP::RSA::PrivateKey *privateKey = nullptr;
         CryptoPP::RSA::PublicKey *publicKey = nullptr;
         size_t cipherLen = 0;
+        /// @brief Built whenever a key is generated or loaded.
+        AsymKeyContexts *contexts = nullptr;
+
+        AsymKeyContexts *getContexts();
 
     public:
         ~AsymKey();
@@ -96,7 +158,7 @@ namespace crypto
         size_t calculateCipherLen();
 
         void encrypt(CryptoPP::byte *plain, size_t plainLen, CryptoPP::byte *cipher, size_t cipherLen);
-        void decrypt(CryptoPP::byte *cipher, size_t cipherLen,
+        void decrypt(const CryptoPP::byte *cipher, size_t cipherLen,
                      CryptoPP::byte *plain, size_t plainLen,
                      size_t *outputLen = nullptr);
     };
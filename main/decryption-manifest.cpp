@@ -0,0 +1,89 @@
+#include <filesystem>
+#include <fstream>
+#include <ios>
+#include <stdexcept>
+#include <string>
+
+#include "json.hpp"
+
+#include "decryption-manifest.h"
+#include "dev-logger.h"
+
+/// Version of the manifest format.
+#define DECRYPTION_MANIFEST_VERSION 1
+
+logger::DecryptionManifest::DecryptionManifest(const std::filesystem::path &destinationDir)
+    : path(destinationDir / DECRYPTION_MANIFEST_FILENAME)
+{
+    if (!std::filesystem::exists(this->path))
+        return;
+
+    try
+    {
+        std::ifstream f(this->path);
+        auto j = nlohmann::json::parse(f);
+        if (j.at("version").get<int>() != DECRYPTION_MANIFEST_VERSION)
+            throw std::runtime_error("Unsupported manifest version");
+
+        for (auto &[fileName, e] : j.at("files").items())
+        {
+            ManifestEntry entry;
+            e.at("offset").get_to(entry.progress.offset);
+            e.at("frames").get_to(entry.progress.frames);
+            e.at("keyOffset").get_to(entry.progress.keyOffset);
+            e.at("outputSize").get_to(entry.outputSize);
+            entry.output = e.value("output", "");
+            this->entries[fileName] = entry;
+        }
+        INFO("Loaded decryption manifest with {} files", this->entries.size());
+    }
+    catch (const std::exception &ex)
+    {
+        WARN("Ignore unreadable decryption manifest `{}`: {}", this->path.u8string(), ex.what());
+        this->entries.clear();
+    }
+}
+
+bool logger::DecryptionManifest::find(const std::string &fileName, ManifestEntry *entry)
+{
+    auto it = this->entries.find(fileName);
+    if (it == this->entries.end())
+        return false;
+
+    *entry = it->second;
+    return true;
+}
+
+void logger::DecryptionManifest::set(const std::string &fileName, const ManifestEntry &entry)
+{
+    this->entries[fileName] = entry;
+}
+
+void logger::DecryptionManifest::remove(const std::string &fileName)
+{
+    this->entries.erase(fileName);
+}
+
+void logger::DecryptionManifest::save()
+{
+    nlohmann::json j;
+    j["version"] = DECRYPTION_MANIFEST_VERSION;
+    j["files"] = nlohmann::json::object();
+    for (auto &[fileName, entry] : this->entries)
+        j["files"][fileName] = {{"offset", entry.progress.offset},
+                                {"frames", entry.progress.frames},
+                                {"keyOffset", entry.progress.keyOffset},
+                                {"outputSize", entry.outputSize},
+                                {"output", entry.output}};
+
+    auto temporaryPath = this->path;
+    temporaryPath += ".tmp";
+    {
+        std::ofstream f(temporaryPath, std::ios::binary | std::ios::trunc);
+        f << j.dump(4);
+        if (!f.flush())
+            throw std::ios_base::failure("Cannot write `" + temporaryPath.u8string() + "`");
+    }
+    std::filesystem::rename(temporaryPath, this->path);
+    DEBUG("Saved decryption manifest with {} files", this->entries.size());
+}
@@ -0,0 +1,60 @@
+#ifndef MAIN_DECRYPTION_MANIFEST
+#define MAIN_DECRYPTION_MANIFEST
+#include <filesystem>
+#include <map>
+#include <string>
+
+/// File name of the manifest in the destination directory of decrypted logs.
+#define DECRYPTION_MANIFEST_FILENAME "decryption-manifest.json"
+
+namespace logger
+{
+    /// @brief How far an encrypted log file has been decrypted.
+    struct DecryptionProgress
+    {
+        /// @brief Offset (in bytes) right after the last decrypted frame,
+        ///        `0` if nothing has been decrypted yet.
+        unsigned long long offset = 0;
+        /// @brief Number of decrypted frames.
+        unsigned long long frames = 0;
+        /// @brief Offset (in bytes) of the key frame the following entries
+        ///        are encrypted with, or their keys are derived from,
+        ///        `0` if there is none.
+        unsigned long long keyOffset = 0;
+    };
+
+    struct ManifestEntry
+    {
+        DecryptionProgress progress;
+        /// @brief Size (in bytes) of the decrypted output at that point.
+        unsigned long long outputSize = 0;
+        /// @brief File name of the decrypted output.
+        std::string output;
+    };
+
+    /// @brief Records, per encrypted log file, how far it has been decrypted,
+    ///        so the next run only decrypts frames appended since.
+    class DecryptionManifest
+    {
+    private:
+        std::filesystem::path path;
+        /// @brief Entries by file name of the encrypted log file.
+        std::map<std::string, ManifestEntry> entries;
+
+    public:
+        /// @brief Load the manifest of a destination directory, if there is one.
+        ///        An unreadable manifest is ignored, so every file is decrypted again.
+        DecryptionManifest(const std::filesystem::path &destinationDir);
+
+        /// @return `false` if the file has not been decrypted before.
+        bool find(const std::string &fileName, ManifestEntry *entry);
+        void set(const std::string &fileName, const ManifestEntry &entry);
+        void remove(const std::string &fileName);
+
+        /// @brief Replace the manifest file atomically,
+        ///        so it is never left half written.
+        void save();
+    };
+}
+
+#endif /* MAIN_DECRYPTION_MANIFEST */
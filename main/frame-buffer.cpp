@@ -0,0 +1,66 @@
+#include <cassert>
+#include <stdexcept>
+#include <vector>
+
+#include "frame-buffer.h"
+#include "log-entry-json.h"
+
+void logger::encodeFrameHeader(DataType type, size_t dataLen, unsigned char *header,
+                               bool compressed)
+{
+    if (dataLen > FRAME_MAX_DATA_LEN)
+        throw std::runtime_error("Data exceeds supported length of 16 megabytes");
+
+    header[0] = static_cast<unsigned char>(type) | (compressed ? FRAME_COMPRESSED_FLAG : 0);
+    header[1] = static_cast<unsigned char>(dataLen >> 16);
+    header[2] = static_cast<unsigned char>(dataLen >> 8);
+    header[3] = static_cast<unsigned char>(dataLen >> 0);
+}
+
+void logger::FrameBuffer::reset(size_t reservedLen)
+{
+    this->buffer.resize(reservedLen);
+}
+
+void logger::FrameBuffer::append(const char *data, size_t dataLen)
+{
+    this->buffer.insert(this->buffer.end(), data, data + dataLen);
+}
+
+void logger::FrameBuffer::append(const LogEntry &entry)
+{
+    writeLogEntryJson(entry, &this->buffer);
+}
+
+void logger::FrameBuffer::appendOffset(size_t offset)
+{
+    char bytes[BATCH_OFFSET_LEN];
+    for (int i = BATCH_OFFSET_LEN - 1; i >= 0; i--)
+    {
+        bytes[i] = static_cast<char>(offset);
+        offset >>= 8;
+    }
+    this->append(bytes, BATCH_OFFSET_LEN);
+}
+
+void logger::FrameBuffer::resize(size_t len)
+{
+    this->buffer.resize(len);
+}
+
+void logger::FrameBuffer::sealHeader(DataType type, bool compressed)
+{
+    assert(this->buffer.size() >= FRAME_HEADER_LEN);
+    encodeFrameHeader(type, this->buffer.size() - FRAME_HEADER_LEN,
+                      reinterpret_cast<unsigned char *>(this->buffer.data()), compressed);
+}
+
+char *logger::FrameBuffer::data()
+{
+    return this->buffer.data();
+}
+
+size_t logger::FrameBuffer::size()
+{
+    return this->buffer.size();
+}
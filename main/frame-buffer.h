@@ -0,0 +1,87 @@
+#ifndef MAIN_FRAME_BUFFER
+#define MAIN_FRAME_BUFFER
+#include <vector>
+
+#include "capturer.h"
+
+/// Version specifier of encrypted log files whose entries are
+/// AES-CBC encrypted, each with its IV prepended.
+#define ENC_LOGFILE_VERSION_CBC 'A'
+/// Version specifier of encrypted log files whose entries are AES-GCM
+/// encrypted, authenticating their frame header too. Nonces count the
+/// entries since the key frame, and every file starts with a new key.
+#define ENC_LOGFILE_VERSION_GCM 'B'
+/// Version specifier on the first byte of new encrypted log files.
+#define ENC_LOGFILE_VERSION ENC_LOGFILE_VERSION_GCM
+/// Length (in bytes) of a frame header: 1 byte data type, 3 bytes data length.
+#define FRAME_HEADER_LEN 4
+/// Maximum length (in bytes) of a frame's data.
+#define FRAME_MAX_DATA_LEN 16777215
+/// Length (in bytes) of each end offset in the table of a batch frame, and of its entry count.
+#define BATCH_OFFSET_LEN 4
+/// Length (in bytes) of the big-endian segment number in a segment key frame.
+#define SEGMENT_NUMBER_LEN 8
+/// Bit of the data type byte set on frames whose plain data is Deflate compressed.
+/// Only AES-GCM files have them, and the flag is authenticated with the header.
+#define FRAME_COMPRESSED_FLAG 0x80
+
+namespace logger
+{
+    enum DataType
+    {
+        DataTypeJson = 0,
+        DataTypeSymKey = 1,
+        /// @brief Several JSON entries encrypted together, only in AES-GCM files.
+        ///        The plain data is the entries' text back to back, followed by
+        ///        the end offset of each entry, then the number of entries.
+        ///        Offsets and the count are `BATCH_OFFSET_LEN` bytes, big-endian.
+        DataTypeJsonBatch = 2,
+        /// @brief Rotates the AES key without RSA, only in AES-GCM files. The data is
+        ///        the segment number, the key being derived from it and the key of
+        ///        the last `DataTypeSymKey` frame (the file key). Entries right after
+        ///        the `DataTypeSymKey` frame are encrypted with the file key itself.
+        DataTypeSegmentKey = 3
+    };
+
+    /// @brief Write the header of a frame.
+    /// @param header Where the `FRAME_HEADER_LEN` bytes of the header will be put.
+    /// @param compressed Is the plain data of the frame compressed?
+    void encodeFrameHeader(DataType type, size_t dataLen, unsigned char *header,
+                           bool compressed = false);
+
+    /// @brief Reusable buffer a whole log frame is assembled in,
+    ///        so it can be handed to the writer in one call.
+    ///        Its capacity is kept between frames, so steady state
+    ///        appends do not allocate.
+    class FrameBuffer
+    {
+    private:
+        std::vector<char> buffer;
+
+    public:
+        FrameBuffer() = default;
+        FrameBuffer(const FrameBuffer &) = delete;
+        FrameBuffer &operator=(const FrameBuffer &) = delete;
+
+        /// @brief Empty the buffer, leaving `reservedLen` bytes at the front
+        ///        (e.g. for the frame header and the IV).
+        void reset(size_t reservedLen = 0);
+
+        void append(const char *data, size_t dataLen);
+        /// @brief Append the compact JSON text of `entry`.
+        void append(const LogEntry &entry);
+        /// @brief Append a `BATCH_OFFSET_LEN` bytes big-endian number.
+        void appendOffset(size_t offset);
+
+        void resize(size_t len);
+
+        /// @brief Fill in the frame header at the front of the buffer
+        ///        for everything that follows it.
+        void sealHeader(DataType type, bool compressed = false);
+
+        char *data();
+        size_t size();
+    };
+}
+
+#endif /* MAIN_FRAME_BUFFER */
@@ -1,21 +1,48 @@
-#include <Windows.h>
+#include <cctype>
+#include <cstdlib>
 #include <filesystem>
 #include <fstream>
 #include <regex>
 #include <string>
-#include <tlhelp32.h>
 #include <vector>
 
+#ifdef _WIN32
+#include <Windows.h>
+#include <tlhelp32.h>
+#else
+#include <dirent.h>
+#include <signal.h>
+#include <sys/types.h>
+#include <unistd.h>
+typedef pid_t DWORD;
+#endif
+
 #include "constants.hpp"
 #include "dev-logger.h"
 #include "helpers.h"
+#include "transcoder.h"
 
-// https://gist.github.com/gchudnov/c1ba72d45e394180e22f
 std::string toUtf8(const std::wstring &wide)
 {
-    std::u16string u16str(wide.begin(), wide.end());
-    std::wstring_convert<std::codecvt_utf8_utf16<char16_t>, char16_t> convert;
-    std::string utf8 = convert.to_bytes(u16str);
+    std::string utf8;
+    if constexpr (sizeof(wchar_t) == sizeof(char16_t))
+    {
+        utf16ToUtf8(reinterpret_cast<const char16_t *>(wide.data()), wide.size(), &utf8);
+        return utf8;
+    }
+
+    std::u16string u16str;
+    for (char32_t c : wide)
+    {
+        if (c < 0x10000)
+            u16str.push_back(static_cast<char16_t>(c));
+        else
+        {
+            u16str.push_back(static_cast<char16_t>(0xD800 + ((c - 0x10000) >> 10)));
+            u16str.push_back(static_cast<char16_t>(0xDC00 + ((c - 0x10000) & 0x3FF)));
+        }
+    }
+    utf16ToUtf8(u16str.data(), u16str.size(), &utf8);
     return utf8;
 }
 
@@ -28,9 +55,13 @@ bool isPathRelative(const std::string path)
 
 std::filesystem::path getExecutablePath()
 {
+#ifdef _WIN32
     CHAR path[MAX_PATH];
     GetModuleFileNameA(NULL, path, MAX_PATH);
     return std::filesystem::path(path);
+#else
+    return std::filesystem::read_symlink("/proc/self/exe");
+#endif
 }
 
 std::filesystem::path getExecutableDirPath()
@@ -65,6 +96,30 @@ std::filesystem::path prepareAndProcessPath(std::filesystem::path in, bool creat
 /// @return List of process ids
 std::vector<DWORD> getProcessIds(const std::string &processName)
 {
+#ifndef _WIN32
+    std::vector<DWORD> ids;
+    DIR *proc = opendir("/proc");
+    if (proc == nullptr)
+        return ids;
+
+    struct dirent *dirEntry;
+    while ((dirEntry = readdir(proc)) != nullptr)
+    {
+        if (!std::isdigit(static_cast<unsigned char>(dirEntry->d_name[0])))
+            continue;
+
+        // `/proc/<pid>/comm` is truncated to 15 characters,
+        // so compare the executable's file name instead.
+        std::error_code ec;
+        auto exe = std::filesystem::read_symlink(
+            std::filesystem::path("/proc") / dirEntry->d_name / "exe", ec);
+        if (!ec && exe.filename().string() == processName)
+            ids.push_back(std::stoi(dirEntry->d_name));
+    }
+
+    closedir(proc);
+    return ids;
+#else
     std::vector<DWORD> ids;
     PROCESSENTRY32 processInfo;
     processInfo.dwSize = sizeof(processInfo);
@@ -91,6 +146,7 @@ std::vector<DWORD> getProcessIds(const std::string &processName)
 
     CloseHandle(processesSnapshot);
     return ids;
+#endif
 }
 
 // https://stackoverflow.com/a/116220
@@ -117,6 +173,15 @@ std::string readFile(std::string_view path)
 // https://stackoverflow.com/a/38158534
 void startProgram(std::string path)
 {
+    INFO("Starting program `{}`", path);
+#ifndef _WIN32
+    if (fork() == 0)
+    {
+        setsid();
+        execl(path.c_str(), path.c_str(), (char *)nullptr);
+        _exit(EXIT_FAILURE);
+    }
+#else
     STARTUPINFOA si;
     PROCESS_INFORMATION pi;
 
@@ -124,7 +189,6 @@ void startProgram(std::string path)
     si.cb = sizeof(si);
     ZeroMemory(&pi, sizeof(pi));
 
-    INFO("Starting program `{}`", path);
     CreateProcessA(
         path.c_str(),
         NULL,               // Command line
@@ -137,19 +201,28 @@ void startProgram(std::string path)
         &si,                // Pointer to STARTUPINFO structure
         &pi                 // Pointer to PROCESS_INFORMATION structure
     );
+#endif
 }
 
 void killProcess(DWORD processId)
 {
+#ifdef _WIN32
     const auto explorer = OpenProcess(PROCESS_TERMINATE, false, processId);
     TerminateProcess(explorer, 1);
     CloseHandle(explorer);
+#else
+    kill(processId, SIGTERM);
+#endif
 }
 
 /// @brief Kill other running perpetual instances except the current process.
 void killOtherPerpetualInstances()
 {
+#ifdef _WIN32
     DWORD currentPId = GetCurrentProcessId();
+#else
+    DWORD currentPId = getpid();
+#endif
     auto ids = getProcessIds(constants::PERPETUAL_EXE_FILENAME);
     for (int i = 0; i < ids.size(); i++)
     {
@@ -0,0 +1,158 @@
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <cryptopp/base64.h>
+#include <cryptopp/files.h>
+#include <cryptopp/filters.h>
+#include <cryptopp/sha.h>
+
+#include "crypto.h"
+#include "dev-logger.h"
+#include "key-cache.h"
+
+double crypto::KeyCacheStats::getHitRate() const
+{
+    auto lookups = this->hits + this->misses;
+    return lookups == 0 ? 0 : static_cast<double>(this->hits) / lookups;
+}
+
+double crypto::KeyCacheStats::getSavedSeconds() const
+{
+    return this->misses == 0 ? 0 : this->hits * this->unwrapSeconds / this->misses;
+}
+
+crypto::KeyCacheStats crypto::KeyCacheStats::since(const KeyCacheStats &before) const
+{
+    KeyCacheStats delta;
+    delta.hits = this->hits - before.hits;
+    delta.misses = this->misses - before.misses;
+    delta.unwrapSeconds = this->unwrapSeconds - before.unwrapSeconds;
+    return delta;
+}
+
+std::string crypto::KeyCache::hash(const CryptoPP::byte *wrapped, size_t wrappedLen)
+{
+    std::string digest(CryptoPP::SHA256::DIGESTSIZE, '\0');
+    CryptoPP::SHA256().CalculateDigest(reinterpret_cast<CryptoPP::byte *>(&digest[0]),
+                                       wrapped, wrappedLen);
+    return digest;
+}
+
+crypto::SymKey *crypto::KeyCache::unwrap(AsymKey *asymKey, const CryptoPP::byte *wrapped, size_t wrappedLen)
+{
+    auto digest = hash(wrapped, wrappedLen);
+    std::vector<CryptoPP::byte> secret;
+
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        auto it = this->secrets.find(digest);
+        if (it != this->secrets.end())
+        {
+            this->stats.hits++;
+            secret = it->second;
+        }
+    }
+
+    if (secret.empty())
+    {
+        // The RSA operation runs outside of the lock, so threads
+        // unwrapping different keys do not wait for each other.
+        auto start = std::chrono::steady_clock::now();
+        secret.resize(wrappedLen);
+        size_t secretLen = 0;
+        asymKey->decrypt(wrapped, wrappedLen, secret.data(), secret.size(), &secretLen);
+        secret.resize(secretLen);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->stats.misses++;
+        this->stats.unwrapSeconds += seconds;
+        this->secrets[digest] = secret;
+    }
+
+    return new SymKey(secret.data(), secret.size());
+}
+
+void crypto::KeyCache::loadFromFile(const std::string &path, SymKey *symKey)
+{
+    using namespace CryptoPP;
+    std::unique_ptr<ByteQueue> q(new ByteQueue);
+    Base64Decoder decoder(new Redirector(*(q.get())));
+
+    DEBUG("Read file `{}` -> decode base 64 -> byte queue", path);
+    FileSource fs(path.c_str(), true, new Redirector(decoder));
+    decoder.MessageEnd();
+
+    std::unique_ptr<ByteQueue> plain(new ByteQueue);
+    DEBUG("Decrypt key cache");
+    symKey->decrypt(q.get(), plain.get());
+
+    // Every record is the hash of the wrapped key,
+    // the length of the secret, and the secret.
+    std::lock_guard<std::mutex> lock(this->mutex);
+    size_t loaded = 0;
+    while (plain->CurrentSize() > 0)
+    {
+        std::string digest(SHA256::DIGESTSIZE, '\0');
+        byte secretLen = 0;
+        if (plain->Get(reinterpret_cast<byte *>(&digest[0]), digest.size()) != digest.size() ||
+            plain->Get(secretLen) != 1)
+            throw CryptoError("KeyCache::loadFromFile: Truncated key cache");
+
+        std::vector<byte> secret(secretLen);
+        if (plain->Get(secret.data(), secret.size()) != secret.size())
+            throw CryptoError("KeyCache::loadFromFile: Truncated key cache");
+
+        this->secrets[digest] = secret;
+        loaded++;
+    }
+    INFO("Loaded {} keys into the key cache", loaded);
+}
+
+void crypto::KeyCache::saveToFile(const std::string &path, SymKey *symKey)
+{
+    using namespace CryptoPP;
+    ByteQueue q;
+
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        for (auto &[digest, secret] : this->secrets)
+        {
+            q.Put(reinterpret_cast<const byte *>(digest.data()), digest.size());
+            q.Put(static_cast<byte>(secret.size()));
+            q.Put(secret.data(), secret.size());
+        }
+    }
+
+    ByteQueue cipher;
+    symKey->encrypt(&q, &cipher);
+
+    // The file is replaced at once, so an interrupted save
+    // does not lose the previously saved keys.
+    auto temporaryPath = path + ".tmp";
+    {
+        DEBUG("Copy from byte queue -> base 64 encoder -> file at `{}`", temporaryPath);
+        FileSink file(temporaryPath.c_str());
+        Base64Encoder encoder(new Redirector(file));
+        cipher.CopyTo(encoder);
+        encoder.MessageEnd();
+    }
+    std::filesystem::rename(std::filesystem::u8path(temporaryPath), std::filesystem::u8path(path));
+    INFO("Saved {} keys of the key cache", this->size());
+}
+
+size_t crypto::KeyCache::size()
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->secrets.size();
+}
+
+crypto::KeyCacheStats crypto::KeyCache::getStats()
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->stats;
+}
@@ -0,0 +1,61 @@
+#ifndef MAIN_KEY_CACHE
+#define MAIN_KEY_CACHE
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <cryptopp/rsa.h>
+
+#include "crypto.h"
+
+namespace crypto
+{
+    struct KeyCacheStats
+    {
+        unsigned long long hits = 0;
+        unsigned long long misses = 0;
+        /// @brief Time spent unwrapping the missed keys with RSA.
+        double unwrapSeconds = 0;
+
+        double getHitRate() const;
+        /// @brief Estimated RSA time the hits have saved,
+        ///        based on the average time of a miss.
+        double getSavedSeconds() const;
+        /// @brief Statistics accumulated since `before`.
+        KeyCacheStats since(const KeyCacheStats &before) const;
+    };
+
+    /// @brief Content-addressed cache of unwrapped AES keys, by the SHA-256 hash
+    ///        of their RSA-wrapped form, so each wrapped key only goes through
+    ///        the RSA private-key operation once. It is safe to share between threads.
+    class KeyCache
+    {
+    private:
+        std::mutex mutex;
+        /// @brief Unwrapped secrets by hash of the wrapped key.
+        std::unordered_map<std::string, std::vector<CryptoPP::byte>> secrets;
+        KeyCacheStats stats;
+
+        static std::string hash(const CryptoPP::byte *wrapped, size_t wrappedLen);
+
+    public:
+        /// @brief Unwrap a key with `asymKey`, unless it is in the cache.
+        /// @param wrapped RSA-encrypted secret
+        /// @param wrappedLen Length (in bytes) of the encrypted secret
+        /// @return New SymKey, owned by the caller.
+        SymKey *unwrap(AsymKey *asymKey, const CryptoPP::byte *wrapped, size_t wrappedLen);
+
+        /// @brief Add the keys saved in a file to the cache.
+        /// @param path File written by `saveToFile`
+        /// @param symKey Key the file is encrypted with
+        void loadFromFile(const std::string &path, SymKey *symKey);
+        /// @brief Save every cached key to a file, encrypted with `symKey`.
+        void saveToFile(const std::string &path, SymKey *symKey);
+
+        size_t size();
+        KeyCacheStats getStats();
+    };
+}
+
+#endif /* MAIN_KEY_CACHE */
@@ -0,0 +1,205 @@
+#include <charconv>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "json.hpp"
+
+#include "capturer.h"
+#include "log-entry-json.h"
+
+static void appendLiteral(std::vector<char> *out, std::string_view literal)
+{
+    out->insert(out->end(), literal.begin(), literal.end());
+}
+
+template <typename Integer>
+static void appendInteger(std::vector<char> *out, Integer value)
+{
+    char digits[24];
+    auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    out->insert(out->end(), digits, result.ptr);
+}
+
+/// @brief Length of the UTF-8 sequence starting at `s[i]`,
+///        following the same rules as nlohmann's strict decoder.
+/// @return 0 if the sequence is invalid.
+static size_t utf8SequenceLen(const unsigned char *s, size_t len, size_t i)
+{
+    unsigned char c = s[i];
+    unsigned char low = 0x80, high = 0xBF;
+    size_t n;
+
+    if (c >= 0xC2 && c <= 0xDF)
+        n = 2;
+    else if (c == 0xE0)
+        n = 3, low = 0xA0;
+    else if (c == 0xED)
+        n = 3, high = 0x9F;
+    else if (c >= 0xE1 && c <= 0xEF)
+        n = 3;
+    else if (c == 0xF0)
+        n = 4, low = 0x90;
+    else if (c == 0xF4)
+        n = 4, high = 0x8F;
+    else if (c >= 0xF1 && c <= 0xF3)
+        n = 4;
+    else
+        return 0;
+
+    if (len - i < n || s[i + 1] < low || s[i + 1] > high)
+        return 0;
+    for (size_t k = 2; k < n; k++)
+        if ((s[i + k] & 0xC0) != 0x80)
+            return 0;
+    return n;
+}
+
+/// @brief Append `text` as a quoted JSON string, escaped like nlohmann does.
+static void appendString(std::vector<char> *out, std::string_view text)
+{
+    size_t start = out->size();
+    auto s = reinterpret_cast<const unsigned char *>(text.data());
+    size_t len = text.size();
+
+    out->push_back('"');
+    size_t i = 0;
+    while (i < len)
+    {
+        // Copy the longest run that needs no escaping at once.
+        size_t runStart = i;
+        while (i < len && s[i] >= 0x20 && s[i] < 0x80 && s[i] != '"' && s[i] != '\\')
+            i++;
+        out->insert(out->end(), text.data() + runStart, text.data() + i);
+        if (i == len)
+            break;
+
+        unsigned char c = s[i];
+        if (c >= 0x80)
+        {
+            size_t n = utf8SequenceLen(s, len, i);
+            if (n == 0)
+            {
+                // nlohmann would throw on invalid UTF-8, replace it instead
+                // the same way nlohmann's lenient mode does.
+                out->resize(start);
+                auto replaced = nlohmann::json(std::string(text)).dump(
+                    -1, ' ', false, nlohmann::json::error_handler_t::replace);
+                appendLiteral(out, replaced);
+                return;
+            }
+            out->insert(out->end(), text.data() + i, text.data() + i + n);
+            i += n;
+            continue;
+        }
+
+        switch (c)
+        {
+        case '"':
+            appendLiteral(out, "\\\"");
+            break;
+        case '\\':
+            appendLiteral(out, "\\\\");
+            break;
+        case '\b':
+            appendLiteral(out, "\\b");
+            break;
+        case '\f':
+            appendLiteral(out, "\\f");
+            break;
+        case '\n':
+            appendLiteral(out, "\\n");
+            break;
+        case '\r':
+            appendLiteral(out, "\\r");
+            break;
+        case '\t':
+            appendLiteral(out, "\\t");
+            break;
+        default:
+        {
+            const char *hex = "0123456789abcdef";
+            char escaped[6] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xF]};
+            out->insert(out->end(), escaped, escaped + sizeof(escaped));
+        }
+        }
+        i++;
+    }
+    out->push_back('"');
+}
+
+/// @brief Append `{"path":...,"title":...}`, with `isActive` first if set.
+///        Keys are in the same (sorted) order as in a nlohmann object.
+static void appendApp(std::vector<char> *out, const AppRecord &app, bool withIsActive)
+{
+    appendLiteral(out, withIsActive && app.isActive ? "{\"isActive\":true,\"path\":" : "{\"path\":");
+    appendString(out, app.path);
+    appendLiteral(out, ",\"title\":");
+    appendString(out, app.title);
+    out->push_back('}');
+}
+
+void writeLogEntryJson(const LogEntry &entry, std::vector<char> *out)
+{
+    switch (entry.type)
+    {
+    case LogEntrySnapshot:
+        appendLiteral(out, "{\"apps\":[");
+        for (size_t i = 0; i < entry.apps.size(); i++)
+        {
+            if (i > 0)
+                out->push_back(',');
+            appendApp(out, entry.apps[i], true);
+        }
+        appendLiteral(out, "],\"time\":");
+        appendInteger(out, entry.timestamp);
+        break;
+
+    case LogEntryIdle:
+        appendLiteral(out, "{\"durationSinceLastInput\":");
+        appendInteger(out, entry.durationSinceLastInput);
+        appendLiteral(out, ",\"timestamp\":");
+        appendInteger(out, entry.timestamp);
+        break;
+
+    case LogEntryFocus:
+        appendLiteral(out, "{\"focus\":");
+        appendApp(out, entry.focus, false);
+        appendLiteral(out, ",\"time\":");
+        appendInteger(out, entry.timestamp);
+        break;
+    }
+    out->push_back('}');
+}
+
+nlohmann::json logEntryToJson(const LogEntry &entry)
+{
+    nlohmann::json j;
+
+    switch (entry.type)
+    {
+    case LogEntrySnapshot:
+        j["time"] = entry.timestamp;
+        j["apps"] = nlohmann::json::array();
+        for (auto const &appRecord : entry.apps)
+        {
+            j["apps"].push_back({{"title", appRecord.title},
+                                 {"path", appRecord.path}});
+            if (appRecord.isActive)
+                j["apps"].back()["isActive"] = true;
+        }
+        break;
+
+    case LogEntryIdle:
+        j["timestamp"] = entry.timestamp;
+        j["durationSinceLastInput"] = entry.durationSinceLastInput;
+        break;
+
+    case LogEntryFocus:
+        j = {{"time", entry.timestamp},
+             {"focus", {{"title", entry.focus.title}, {"path", entry.focus.path}}}};
+        break;
+    }
+
+    return j;
+}
@@ -0,0 +1,20 @@
+#ifndef MAIN_LOG_ENTRY_JSON
+#define MAIN_LOG_ENTRY_JSON
+#include <vector>
+
+#include "json.hpp"
+
+#include "capturer.h"
+
+/// @brief Append the compact JSON text of `entry` straight from its records,
+///        without building a DOM. The text is byte for byte what
+///        `logEntryToJson(entry).dump()` gives.
+/// @param entry Captured log entry
+/// @param out Where the JSON text will be appended.
+void writeLogEntryJson(const LogEntry &entry, std::vector<char> *out);
+
+/// @brief Build the JSON DOM of `entry`. It is the reference
+///        `writeLogEntryJson` is checked against in the tests.
+nlohmann::json logEntryToJson(const LogEntry &entry);
+
+#endif /* MAIN_LOG_ENTRY_JSON */
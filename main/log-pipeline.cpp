@@ -0,0 +1,193 @@
+#include <chrono>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <time.h>
+
+#include "capturer.h"
+#include "dev-logger.h"
+#include "log-pipeline.h"
+
+/// How many written entries between queue statistics reports.
+#define PIPELINE_STATS_LOG_INTERVAL 60
+/// Upper bound (in milliseconds) on how long the writer thread sleeps without checking the queue.
+#define PIPELINE_WRITER_WAIT_MS 1000
+
+logger::OverflowPolicy logger::parseOverflowPolicy(const std::string &policy)
+{
+    if (policy == "block")
+        return OverflowBlock;
+    if (policy == "drop")
+        return OverflowDrop;
+    throw std::invalid_argument("Unknown queue overflow policy `" + policy + "`");
+}
+
+LogEntry *logger::CapturedEntry::reset()
+{
+    this->entry.reset();
+    this->arena.reset();
+    return &this->entry.emplace(this->arena.resource());
+}
+
+logger::LogPipeline::LogPipeline(Config *config)
+    : config(config),
+      queue(config->queue.capacity == 0 ? 1 : config->queue.capacity)
+{
+    this->overflowPolicy = parseOverflowPolicy(config->queue.overflow);
+    this->logger = new Logger(config);
+
+    INFO("Start writer thread with a queue capacity of {}", this->queue.getCapacity());
+    this->writerThread = std::thread(&LogPipeline::runWriter, this);
+}
+
+void logger::LogPipeline::capture()
+{
+    time_t timestamp = time(nullptr);
+    CapturedEntry *slot = this->acquireSlot(timestamp);
+    if (slot == nullptr)
+        return;
+
+    this->logger->capture(timestamp, slot->reset());
+    this->publish();
+}
+
+void logger::LogPipeline::captureFocus()
+{
+    time_t timestamp = time(nullptr);
+    CapturedEntry *slot = this->acquireSlot(timestamp);
+    if (slot == nullptr)
+        return;
+
+    // An unpublished slot is simply filled in again by the next capture.
+    if (!this->logger->captureFocus(timestamp, slot->reset()))
+        return;
+
+    this->publish();
+}
+
+void logger::LogPipeline::publish()
+{
+    this->queue.commitPush();
+    this->captured++;
+
+    size_t depth = this->queue.size();
+    if (depth > this->maxDepth.load())
+        this->maxDepth = depth;
+
+    {
+        std::lock_guard<std::mutex> lock(this->waitMutex);
+    }
+    this->notEmpty.notify_one();
+}
+
+logger::CapturedEntry *logger::LogPipeline::acquireSlot(time_t timestamp)
+{
+    CapturedEntry *slot = this->queue.beginPush();
+
+    if (slot == nullptr && this->overflowPolicy == OverflowBlock)
+    {
+        DEBUG("Log queue is full, wait for the writer thread");
+        std::unique_lock<std::mutex> lock(this->waitMutex);
+        this->notFull.wait(lock, [&]()
+                           { return (slot = this->queue.beginPush()) != nullptr ||
+                                    this->stopping.load(); });
+    }
+
+    if (slot == nullptr)
+    {
+        this->dropped++;
+        WARN("Log queue is full, dropped entry at timestamp {} ({} dropped so far)",
+             timestamp, this->dropped.load());
+    }
+    return slot;
+}
+
+void logger::LogPipeline::runWriter()
+{
+    while (true)
+    {
+        CapturedEntry *item = this->queue.front();
+        if (item == nullptr)
+        {
+            if (this->stopping.load())
+                break;
+
+            // Batched entries are written once they are too old,
+            // even when no new entry comes to push them out.
+            try
+            {
+                this->logger->commitBatchIfDue();
+            }
+            catch (const std::exception &ex)
+            {
+                SPDERROR("Failed to write batched log entries: {}", ex.what());
+            }
+
+            std::unique_lock<std::mutex> lock(this->waitMutex);
+            this->notEmpty.wait_for(lock,
+                                    std::chrono::milliseconds(PIPELINE_WRITER_WAIT_MS),
+                                    [&]()
+                                    { return !this->queue.empty() || this->stopping.load(); });
+            continue;
+        }
+
+        try
+        {
+            this->logger->write(*item->entry);
+        }
+        catch (const std::exception &ex)
+        {
+            SPDERROR("Failed to write log entry: {}", ex.what());
+        }
+
+        this->queue.pop();
+        this->written++;
+
+        {
+            std::lock_guard<std::mutex> lock(this->waitMutex);
+        }
+        this->notFull.notify_one();
+
+        if (this->written % PIPELINE_STATS_LOG_INTERVAL == 0)
+        {
+            auto stats = this->getStats();
+            INFO("Log queue: depth {}, max depth {}, captured {}, written {}, dropped {}",
+                 stats.depth, stats.maxDepth, stats.captured, stats.written, stats.dropped);
+        }
+    }
+
+    this->logger->flush();
+}
+
+void logger::LogPipeline::stop()
+{
+    if (!this->writerThread.joinable())
+        return;
+
+    INFO("Stop writer thread");
+    {
+        std::lock_guard<std::mutex> lock(this->waitMutex);
+        this->stopping = true;
+    }
+    this->notEmpty.notify_all();
+    this->notFull.notify_all();
+    this->writerThread.join();
+}
+
+logger::PipelineStats logger::LogPipeline::getStats()
+{
+    PipelineStats stats;
+    stats.depth = this->queue.size();
+    stats.maxDepth = this->maxDepth.load();
+    stats.captured = this->captured.load();
+    stats.written = this->written.load();
+    stats.dropped = this->dropped.load();
+    return stats;
+}
+
+logger::LogPipeline::~LogPipeline()
+{
+    this->stop();
+    delete this->logger;
+}
@@ -0,0 +1,105 @@
+#ifndef MAIN_LOG_PIPELINE
+#define MAIN_LOG_PIPELINE
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <time.h>
+
+#include "capture-arena.h"
+#include "capturer.h"
+#include "config.h"
+#include "logger.h"
+#include "spsc-queue.hpp"
+
+namespace logger
+{
+    enum OverflowPolicy
+    {
+        /// @brief Wait for the writer thread to make room.
+        OverflowBlock,
+        /// @brief Discard the new entry.
+        OverflowDrop
+    };
+
+    /// @brief Convert the `queue.overflow` config value into an `OverflowPolicy`.
+    ///        Throws `std::invalid_argument` on unknown values.
+    OverflowPolicy parseOverflowPolicy(const std::string &policy);
+
+    /// @brief A queue slot. The entry is allocated in the slot's own arena,
+    ///        so it stays valid while the writer thread serializes it,
+    ///        and the next capture into the slot reuses the memory.
+    struct CapturedEntry
+    {
+        CaptureArena arena;
+        std::optional<LogEntry> entry;
+
+        /// @brief Release the previous entry, and start an empty one in the arena.
+        LogEntry *reset();
+    };
+
+    struct PipelineStats
+    {
+        /// @brief Entries currently waiting to be written.
+        size_t depth = 0;
+        /// @brief Highest depth seen so far.
+        size_t maxDepth = 0;
+        unsigned long long captured = 0;
+        unsigned long long written = 0;
+        unsigned long long dropped = 0;
+    };
+
+    /// @brief Captures on the calling thread, and hands the entries
+    ///        to a writer thread that serializes, encrypts and appends them,
+    ///        so slow disks or RSA operations do not delay the next capture.
+    class LogPipeline
+    {
+    private:
+        Config *config = nullptr;
+        Logger *logger = nullptr;
+        OverflowPolicy overflowPolicy = OverflowBlock;
+
+        SpscQueue<CapturedEntry> queue;
+        std::thread writerThread;
+        std::atomic<bool> stopping{false};
+
+        /// @brief Only used to sleep and wake up, the queue itself is lock-free.
+        std::mutex waitMutex;
+        std::condition_variable notEmpty;
+        std::condition_variable notFull;
+
+        std::atomic<size_t> maxDepth{0};
+        std::atomic<unsigned long long> captured{0};
+        std::atomic<unsigned long long> written{0};
+        std::atomic<unsigned long long> dropped{0};
+
+        void runWriter();
+        /// @brief Wait for a free slot according to the overflow policy.
+        /// @param timestamp UNIX timestamp of the entry to be captured
+        /// @return `nullptr` if the entry has been dropped.
+        CapturedEntry *acquireSlot(time_t timestamp);
+        /// @brief Hand the filled in slot over to the writer thread.
+        void publish();
+
+    public:
+        LogPipeline(Config *config);
+        LogPipeline(const LogPipeline &) = delete;
+        LogPipeline &operator=(const LogPipeline &) = delete;
+        ~LogPipeline();
+
+        /// @brief Capture a log snapshot and queue it for writing.
+        void capture();
+        /// @brief Probe the app in focus, and queue a compact entry
+        ///        for writing if the focus has changed.
+        void captureFocus();
+
+        /// @brief Write all queued entries and stop the writer thread.
+        void stop();
+
+        PipelineStats getStats();
+    };
+}
+
+#endif /* MAIN_LOG_PIPELINE */
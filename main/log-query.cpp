@@ -0,0 +1,149 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <ios>
+#include <string>
+#include <vector>
+
+#include "json.hpp"
+
+#include "dev-logger.h"
+#include "log-query.h"
+
+time_t logger::getEntryTime(const nlohmann::json &entry)
+{
+    auto it = entry.find("time");
+    if (it == entry.end())
+        it = entry.find("timestamp");
+    return it == entry.end() ? 0 : it->get<time_t>();
+}
+
+/// @brief Path of the active app of an entry, empty if there is none.
+static std::string getActivePath(const nlohmann::json &entry)
+{
+    auto focus = entry.find("focus");
+    if (focus != entry.end())
+        return focus->value("path", "");
+
+    auto apps = entry.find("apps");
+    if (apps != entry.end())
+        for (auto const &app : *apps)
+            if (app.value("isActive", false))
+                return app.value("path", "");
+    return "";
+}
+
+/// @brief Parse a decrypted entry. An entry that is not valid JSON (e.g. one of
+///        a version 'A' file, whose frames are not authenticated, altered into
+///        garbage) gives a discarded value rather than throwing.
+static nlohmann::json parseEntry(const char *text, size_t textLen)
+{
+    auto entry = nlohmann::json::parse(text, text + textLen, nullptr, false);
+    if (entry.is_discarded())
+        WARN("Skip log entry of {} bytes that is not valid JSON", textLen);
+    return entry;
+}
+
+logger::StreamLogSink::StreamLogSink(FILE *stream) : stream(stream) {}
+
+void logger::StreamLogSink::writeEntry(const char *text, size_t textLen)
+{
+    if (std::fwrite(text, 1, textLen, this->stream) != textLen ||
+        std::fputc('\n', this->stream) == EOF)
+        throw std::ios_base::failure(std::strerror(errno));
+}
+
+logger::LogEntryFilter::LogEntryFilter(LogSink *next, time_t from, time_t to,
+                                       const std::string &pattern)
+    : next(next), from(from), to(to)
+{
+    if (pattern.empty())
+        return;
+    this->pattern = std::regex(pattern, std::regex_constants::icase);
+    this->hasPattern = true;
+}
+
+bool logger::LogEntryFilter::matches(const nlohmann::json &entry)
+{
+    time_t time = getEntryTime(entry);
+    if ((this->from != 0 && time < this->from) || (this->to != 0 && time > this->to))
+        return false;
+    if (!this->hasPattern)
+        return true;
+
+    auto appMatches = [this](const nlohmann::json &app)
+    {
+        return std::regex_search(app.value("path", ""), this->pattern) ||
+               std::regex_search(app.value("title", ""), this->pattern);
+    };
+
+    auto focus = entry.find("focus");
+    if (focus != entry.end() && appMatches(*focus))
+        return true;
+
+    auto apps = entry.find("apps");
+    if (apps != entry.end())
+        return std::any_of(apps->begin(), apps->end(), appMatches);
+    return false;
+}
+
+void logger::LogEntryFilter::writeEntry(const char *text, size_t textLen)
+{
+    auto entry = parseEntry(text, textLen);
+    if (entry.is_discarded())
+    {
+        this->discarded++;
+        return;
+    }
+    if (this->matches(entry))
+        this->next->writeEntry(text, textLen);
+}
+
+unsigned long long logger::LogEntryFilter::getDiscarded() const
+{
+    return this->discarded;
+}
+
+logger::AppUsageAggregator::AppUsageAggregator(unsigned int maxGap) : maxGap(maxGap) {}
+
+void logger::AppUsageAggregator::writeEntry(const char *text, size_t textLen)
+{
+    auto entry = parseEntry(text, textLen);
+    if (entry.is_discarded())
+    {
+        this->discarded++;
+        return;
+    }
+    time_t time = getEntryTime(entry);
+
+    // Time going backwards (e.g. a clock change) counts for nothing.
+    if (!this->activePath.empty() && time > this->lastTime &&
+        time - this->lastTime <= static_cast<time_t>(this->maxGap))
+        this->usage[this->activePath].seconds += time - this->lastTime;
+
+    this->activePath = getActivePath(entry);
+    this->lastTime = time;
+    if (!this->activePath.empty())
+    {
+        auto &appUsage = this->usage[this->activePath];
+        appUsage.path = this->activePath;
+        appUsage.entries++;
+    }
+}
+
+unsigned long long logger::AppUsageAggregator::getDiscarded() const
+{
+    return this->discarded;
+}
+
+std::vector<logger::AppUsage> logger::AppUsageAggregator::getUsage() const
+{
+    std::vector<AppUsage> usage;
+    for (auto const &[path, appUsage] : this->usage)
+        usage.push_back(appUsage);
+
+    std::stable_sort(usage.begin(), usage.end(), [](const AppUsage &a, const AppUsage &b)
+                     { return a.seconds > b.seconds; });
+    return usage;
+}
@@ -0,0 +1,100 @@
+#ifndef MAIN_LOG_QUERY
+#define MAIN_LOG_QUERY
+#include <cstdio>
+#include <ctime>
+#include <map>
+#include <regex>
+#include <string>
+#include <vector>
+
+#include "json.hpp"
+
+#include "log-reader.h"
+
+namespace logger
+{
+    /// @brief UNIX timestamp of a decrypted entry. Idle entries
+    ///        name it `timestamp`, every other entry `time`.
+    time_t getEntryTime(const nlohmann::json &entry);
+
+    /// @brief Writes entries to an open stream (e.g. stdout) as JSON Lines.
+    class StreamLogSink : public LogSink
+    {
+    private:
+        FILE *stream = nullptr;
+
+    public:
+        StreamLogSink(FILE *stream);
+
+        void writeEntry(const char *text, size_t textLen) override;
+    };
+
+    /// @brief Passes on the entries within a time range whose apps match a pattern.
+    class LogEntryFilter : public LogSink
+    {
+    private:
+        LogSink *next = nullptr;
+        time_t from = 0;
+        time_t to = 0;
+        std::regex pattern;
+        bool hasPattern = false;
+        /// @brief Number of entries skipped as they are not valid JSON.
+        unsigned long long discarded = 0;
+
+        bool matches(const nlohmann::json &entry);
+
+    public:
+        /// @param next Where the matching entries are passed on to.
+        /// @param from First UNIX timestamp to pass on, `0` for no limit.
+        /// @param to Last UNIX timestamp to pass on, `0` for no limit.
+        /// @param pattern Regular expression searched for in the path and title
+        ///                of every app of an entry. Empty to pass on every entry.
+        ///                Idle entries have no apps, so they never match it.
+        LogEntryFilter(LogSink *next, time_t from = 0, time_t to = 0,
+                       const std::string &pattern = "");
+
+        void writeEntry(const char *text, size_t textLen) override;
+
+        /// @return Number of entries skipped as they are not valid JSON.
+        unsigned long long getDiscarded() const;
+    };
+
+    struct AppUsage
+    {
+        std::string path;
+        /// @brief Seconds the app was active for.
+        unsigned long long seconds = 0;
+        /// @brief Number of entries the app was active in.
+        unsigned long long entries = 0;
+    };
+
+    /// @brief Adds up how long each app was active. The time between two
+    ///        entries goes to the app active in the first one. Idle entries,
+    ///        and entries without an active app, count for no app.
+    class AppUsageAggregator : public LogSink
+    {
+    private:
+        /// @brief Longest gap (in seconds) between two entries that still counts,
+        ///        so the time the logger was not running is left out.
+        unsigned int maxGap = 0;
+        std::map<std::string, AppUsage> usage;
+        std::string activePath;
+        time_t lastTime = 0;
+        /// @brief Number of entries skipped as they are not valid JSON.
+        unsigned long long discarded = 0;
+
+    public:
+        /// @param maxGap Longest gap (in seconds) between two entries that still counts.
+        AppUsageAggregator(unsigned int maxGap);
+
+        void writeEntry(const char *text, size_t textLen) override;
+
+        /// @return Usage of every app that was active, most used first.
+        std::vector<AppUsage> getUsage() const;
+
+        /// @return Number of entries skipped as they are not valid JSON.
+        unsigned long long getDiscarded() const;
+    };
+}
+
+#endif /* MAIN_LOG_QUERY */
@@ -0,0 +1,359 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <ios>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "dev-logger.h"
+#include "frame-buffer.h"
+#include "log-reader.h"
+
+/// Size (in bytes) of the stdio buffer behind a log file being read.
+#define LOG_READER_BUFFER_SIZE 1048576
+/// Size (in bytes) of the stdio buffer behind a log file being written by a sink.
+#define LOG_SINK_BUFFER_SIZE 65536
+
+static void seekFile(FILE *file, unsigned long long offset)
+{
+#ifdef _WIN32
+    int result = _fseeki64(file, offset, SEEK_SET);
+#else
+    int result = fseeko(file, offset, SEEK_SET);
+#endif
+    if (result != 0)
+        throw std::ios_base::failure(std::strerror(errno));
+}
+
+static FILE *openFile(const std::filesystem::path &path, bool write)
+{
+#ifdef _WIN32
+    FILE *file = _wfopen(path.c_str(), write ? L"ab" : L"rb");
+#else
+    FILE *file = std::fopen(path.c_str(), write ? "ab" : "rb");
+#endif
+    if (file == nullptr)
+        throw std::ios_base::failure(path.u8string() + ": " + std::strerror(errno));
+    return file;
+}
+
+logger::LogReader::LogReader(const std::filesystem::path &path, bool useMapping) : path(path)
+{
+    // Frames are read straight from the page cache when the file can be mapped.
+    this->mapped = useMapping && this->mapping.open(path);
+    int versionSpecifier = EOF;
+    if (this->mapped)
+    {
+        // Only what was mapped can be read, even if the file
+        // has been appended to or truncated since.
+        this->fileSize = this->mapping.getSize();
+        versionSpecifier = this->mapping.getData()[0];
+    }
+    else
+    {
+        DEBUG("Read log file `{}` without a memory mapping", path.u8string());
+        this->fileSize = std::filesystem::file_size(path);
+        this->file = openFile(path, false);
+        std::setvbuf(this->file, nullptr, _IOFBF, LOG_READER_BUFFER_SIZE);
+        versionSpecifier = std::fgetc(this->file);
+    }
+
+    if (versionSpecifier != ENC_LOGFILE_VERSION_CBC && versionSpecifier != ENC_LOGFILE_VERSION_GCM)
+    {
+        if (this->file != nullptr)
+            std::fclose(this->file);
+        this->file = nullptr;
+        throw std::runtime_error("Invalid version specifier in log file `" + path.u8string() + "`");
+    }
+    this->version = static_cast<char>(versionSpecifier);
+    this->offset = 1;
+}
+
+bool logger::LogReader::readHeader(LogFrame *frame)
+{
+    unsigned char buffer[FRAME_HEADER_LEN];
+    const unsigned char *header = buffer;
+    size_t headerLen = 0;
+
+    if (this->mapped)
+    {
+        header = this->mapping.getData() + this->offset;
+        if (this->offset < this->fileSize)
+            headerLen = std::min<unsigned long long>(FRAME_HEADER_LEN, this->fileSize - this->offset);
+    }
+    else
+        headerLen = std::fread(buffer, 1, FRAME_HEADER_LEN, this->file);
+
+    if (headerLen == 0)
+        return false;
+
+    if (headerLen < FRAME_HEADER_LEN)
+    {
+        WARN("Log file `{}` ends with a truncated frame header at byte {}",
+             this->path.u8string(), this->offset);
+        return false;
+    }
+
+    int type = header[0] & ~FRAME_COMPRESSED_FLAG;
+    if (type != DataTypeJson && type != DataTypeSymKey && type != DataTypeJsonBatch &&
+        type != DataTypeSegmentKey)
+        throw std::runtime_error("Unknown data type " + std::to_string(header[0]) +
+                                 " at byte " + std::to_string(this->offset) +
+                                 " of log file `" + this->path.u8string() + "`");
+
+    frame->type = static_cast<DataType>(type);
+    frame->compressed = (header[0] & FRAME_COMPRESSED_FLAG) != 0;
+    frame->offset = this->offset;
+    frame->data = nullptr;
+    frame->dataLen = (header[1] << 16) | (header[2] << 8) | (header[3] << 0);
+    frame->version = this->version;
+
+    if (this->offset + FRAME_HEADER_LEN + frame->dataLen > this->fileSize)
+    {
+        WARN("Log file `{}` ends with a truncated frame at byte {}",
+             this->path.u8string(), this->offset);
+        return false;
+    }
+    return true;
+}
+
+bool logger::LogReader::next(LogFrame *frame)
+{
+    if (!this->readHeader(frame))
+        return false;
+
+    if (this->mapped)
+        frame->data = this->mapping.getData() + this->offset + FRAME_HEADER_LEN;
+    else
+    {
+        this->buffer.resize(frame->dataLen);
+        if (std::fread(this->buffer.data(), 1, frame->dataLen, this->file) < frame->dataLen)
+        {
+            WARN("Log file `{}` ends with a truncated frame at byte {}",
+                 this->path.u8string(), this->offset);
+            return false;
+        }
+        frame->data = this->buffer.data();
+    }
+
+    this->offset += FRAME_HEADER_LEN + frame->dataLen;
+    return true;
+}
+
+bool logger::LogReader::nextHeader(LogFrame *frame)
+{
+    if (!this->readHeader(frame))
+        return false;
+
+    this->offset += FRAME_HEADER_LEN + frame->dataLen;
+    if (!this->mapped)
+        seekFile(this->file, this->offset);
+    return true;
+}
+
+void logger::LogReader::seek(unsigned long long offset)
+{
+    if (!this->mapped)
+        seekFile(this->file, offset);
+    this->offset = offset;
+}
+
+unsigned long long logger::LogReader::getOffset()
+{
+    return this->offset;
+}
+
+char logger::LogReader::getVersion()
+{
+    return this->version;
+}
+
+char logger::readLogFileVersion(const std::filesystem::path &path)
+{
+    FILE *file = openFile(path, false);
+    int versionSpecifier = std::fgetc(file);
+    std::fclose(file);
+
+    if (versionSpecifier != ENC_LOGFILE_VERSION_CBC && versionSpecifier != ENC_LOGFILE_VERSION_GCM)
+        throw std::runtime_error("Invalid version specifier in log file `" + path.u8string() + "`");
+    return static_cast<char>(versionSpecifier);
+}
+
+std::vector<logger::LogSegment> logger::scanSegments(const std::filesystem::path &path,
+                                                    unsigned long long begin,
+                                                    unsigned long long keyOffset)
+{
+    LogReader reader(path);
+    LogFrame frame;
+    if (begin != 0)
+        reader.seek(begin);
+
+    std::vector<LogSegment> segments(1);
+    segments.back().begin = segments.back().end = reader.getOffset();
+
+    while (reader.nextHeader(&frame))
+    {
+        bool isKey = frame.type == DataTypeSymKey || frame.type == DataTypeSegmentKey;
+        if (isKey && frame.offset != segments.back().begin)
+        {
+            segments.back().end = frame.offset;
+            segments.emplace_back().begin = frame.offset;
+        }
+        if (frame.type == DataTypeSymKey)
+            keyOffset = frame.offset;
+        if (frame.offset == segments.back().begin)
+            segments.back().keyOffset = keyOffset;
+        segments.back().end = reader.getOffset();
+    }
+
+    if (segments.back().begin == segments.back().end)
+        segments.pop_back();
+    return segments;
+}
+
+unsigned long long logger::trimTornTail(const std::filesystem::path &path)
+{
+    std::error_code error;
+    auto fileSize = std::filesystem::file_size(path, error);
+    if (error || fileSize == 0)
+        return 0;
+
+    unsigned long long validEnd = 0;
+    {
+        LogReader reader(path);
+        LogFrame frame;
+        while (reader.nextHeader(&frame))
+            ;
+        validEnd = reader.getOffset();
+    }
+
+    if (validEnd == fileSize)
+        return 0;
+    WARN("Trim torn frame off `{}`, from {} to {} bytes", path.u8string(), fileSize, validEnd);
+    std::filesystem::resize_file(path, validEnd);
+    return fileSize - validEnd;
+}
+
+/// @brief Read a `BATCH_OFFSET_LEN` bytes big-endian number.
+static size_t readOffset(const unsigned char *bytes)
+{
+    size_t offset = 0;
+    for (int i = 0; i < BATCH_OFFSET_LEN; i++)
+        offset = (offset << 8) | bytes[i];
+    return offset;
+}
+
+bool logger::writeBatchEntries(const unsigned char *plain, size_t plainLen,
+                               LogSink *sink, unsigned int *entries)
+{
+    *entries = 0;
+    if (plainLen < BATCH_OFFSET_LEN)
+        return false;
+
+    size_t count = readOffset(plain + plainLen - BATCH_OFFSET_LEN);
+    if (count > plainLen / BATCH_OFFSET_LEN - 1)
+        return false;
+
+    // The offsets must rise, and the last one must end where the table begins.
+    size_t textLen = plainLen - (count + 1) * BATCH_OFFSET_LEN;
+    const unsigned char *table = plain + textLen;
+    size_t end = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        size_t next = readOffset(table + i * BATCH_OFFSET_LEN);
+        if (next < end || next > textLen)
+            return false;
+        end = next;
+    }
+    if (end != textLen)
+        return false;
+
+    size_t begin = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        end = readOffset(table + i * BATCH_OFFSET_LEN);
+        sink->writeEntry(reinterpret_cast<const char *>(plain) + begin, end - begin);
+        begin = end;
+    }
+    *entries = static_cast<unsigned int>(count);
+    return true;
+}
+
+void logger::MemoryLogSink::writeEntry(const char *text, size_t textLen)
+{
+    this->text.insert(this->text.end(), text, text + textLen);
+    this->lengths.push_back(textLen);
+}
+
+void logger::MemoryLogSink::replay(LogSink *sink)
+{
+    const char *text = this->text.data();
+    for (size_t length : this->lengths)
+    {
+        sink->writeEntry(text, length);
+        text += length;
+    }
+}
+
+size_t logger::MemoryLogSink::getSize()
+{
+    return this->text.size();
+}
+
+logger::LogReader::~LogReader()
+{
+    if (this->file != nullptr)
+        std::fclose(this->file);
+}
+
+logger::LogFileFormat logger::parseLogFileFormat(const std::string &format)
+{
+    if (format == "log")
+        return LogFileFormatLog;
+    if (format == "jsonl")
+        return LogFileFormatJsonLines;
+    throw std::invalid_argument("Unknown log file format `" + format + "`");
+}
+
+const char *logger::getLogFileSuffix(LogFileFormat format)
+{
+    return format == LogFileFormatJsonLines ? ".jsonl" : ".json.log";
+}
+
+logger::FileLogSink::FileLogSink(const std::filesystem::path &path, unsigned long long keepLen,
+                                 LogFileFormat format)
+    : format(format)
+{
+    if (std::filesystem::exists(path))
+        std::filesystem::resize_file(path, keepLen);
+    else if (keepLen != 0)
+        throw std::runtime_error("Cannot keep the content of missing file `" + path.u8string() + "`");
+
+    this->size = keepLen;
+    this->file = openFile(path, true);
+    std::setvbuf(this->file, nullptr, _IOFBF, LOG_SINK_BUFFER_SIZE);
+}
+
+void logger::FileLogSink::writeEntry(const char *text, size_t textLen)
+{
+    bool lineBreakFirst = this->format == LogFileFormatLog;
+    if ((lineBreakFirst && std::fputc('\n', this->file) == EOF) ||
+        std::fwrite(text, 1, textLen, this->file) != textLen ||
+        (!lineBreakFirst && std::fputc('\n', this->file) == EOF))
+        throw std::ios_base::failure(std::strerror(errno));
+    this->size += 1 + textLen;
+}
+
+unsigned long long logger::FileLogSink::getSize()
+{
+    return this->size;
+}
+
+logger::FileLogSink::~FileLogSink()
+{
+    std::fclose(this->file);
+}
@@ -0,0 +1,193 @@
+#ifndef MAIN_LOG_READER
+#define MAIN_LOG_READER
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "frame-buffer.h"
+#include "mapped-file.h"
+
+namespace logger
+{
+    /// @brief A frame of an encrypted log file.
+    struct LogFrame
+    {
+        DataType type = DataTypeJson;
+        /// @brief Offset (in bytes) of the frame header in the file.
+        unsigned long long offset = 0;
+        /// @brief Frame data, valid until the next frame is read.
+        ///        It may point straight into a memory mapping of the file.
+        const unsigned char *data = nullptr;
+        size_t dataLen = 0;
+        /// @brief Version specifier of the file, which says how the data is encrypted.
+        char version = ENC_LOGFILE_VERSION;
+        /// @brief Is the plain data Deflate compressed?
+        bool compressed = false;
+    };
+
+    /// @brief Frames that only need the key frame they start with,
+    ///        and the file key, if it is a segment key frame.
+    struct LogSegment
+    {
+        /// @brief Offset (in bytes) of the first frame.
+        unsigned long long begin = 0;
+        /// @brief Offset (in bytes) right after the last frame.
+        unsigned long long end = 0;
+        /// @brief Offset (in bytes) of the last `DataTypeSymKey` frame at or
+        ///        before `begin`, `0` if it has not been scanned.
+        unsigned long long keyOffset = 0;
+    };
+
+    /// @brief Walks the frames of an encrypted log file sequentially.
+    ///        The file is memory mapped when possible, and frames point into
+    ///        the mapping. Otherwise it is read, and only the current frame is
+    ///        held in memory. Either way, memory use does not depend on the
+    ///        size of the file.
+    class LogReader
+    {
+    private:
+        std::filesystem::path path;
+        MappedFile mapping;
+        bool mapped = false;
+        /// @brief Only open when the file is not mapped.
+        FILE *file = nullptr;
+        unsigned long long fileSize = 0;
+        /// @brief Offset (in bytes) of the next frame.
+        unsigned long long offset = 0;
+        char version = ENC_LOGFILE_VERSION;
+        /// @brief Reused for every frame, when the file is not mapped.
+        std::vector<unsigned char> buffer;
+
+        /// @brief Read and check the header of the frame at the current offset.
+        /// @return `false` at the end of the file, or if the frame is truncated.
+        bool readHeader(LogFrame *frame);
+
+    public:
+        /// @brief Open the log file and check its version specifier.
+        ///        Throws `std::runtime_error` if it is not a supported log file.
+        ///        Every version is supported.
+        /// @param useMapping Memory map the file if possible, instead of reading it.
+        LogReader(const std::filesystem::path &path, bool useMapping = true);
+        LogReader(const LogReader &) = delete;
+        LogReader &operator=(const LogReader &) = delete;
+        ~LogReader();
+
+        /// @brief Read the next frame.
+        ///        A truncated frame at the end of the file is reported and skipped.
+        /// @param frame Where the frame will be put.
+        /// @return `false` if there are no more frames.
+        bool next(LogFrame *frame);
+        /// @brief Read only the header of the next frame, and skip its data.
+        ///        `frame->data` is left `nullptr`.
+        /// @return `false` if there are no more frames.
+        bool nextHeader(LogFrame *frame);
+
+        /// @brief Continue reading at the frame starting at `offset`.
+        void seek(unsigned long long offset);
+        /// @brief Offset (in bytes) of the next frame.
+        unsigned long long getOffset();
+        /// @brief Version specifier of the file.
+        char getVersion();
+    };
+
+    /// @brief Read the version specifier of an encrypted log file.
+    ///        Throws `std::runtime_error` if it is not a supported one.
+    char readLogFileVersion(const std::filesystem::path &path);
+
+    /// @brief Split a log file at its key and segment key frames, only reading
+    ///        frame headers. Every segment but the first starts with one of them.
+    /// @param begin Offset (in bytes) of the frame to start at,
+    ///              `0` for the first frame of the file.
+    /// @param keyOffset Offset (in bytes) of the last `DataTypeSymKey` frame before
+    ///                  `begin`, which the segments up to the next one are derived
+    ///                  from. `0` if there is none, or it is not known.
+    std::vector<LogSegment> scanSegments(const std::filesystem::path &path,
+                                         unsigned long long begin = 0,
+                                         unsigned long long keyOffset = 0);
+
+    /// @brief Truncate an encrypted log file that ends with a partly written frame
+    ///        (e.g. when the logger was killed mid-write) to its last complete
+    ///        frame, so frames appended to it later can be read. Only frame
+    ///        headers are read. A missing or empty file is left alone.
+    /// @return Number of bytes cut off.
+    unsigned long long trimTornTail(const std::filesystem::path &path);
+
+    /// @brief Receives decrypted log entries.
+    class LogSink
+    {
+    public:
+        virtual ~LogSink(){};
+
+        /// @param text JSON text of the entry, without the line break.
+        /// @param textLen Length (in bytes) of the text.
+        virtual void writeEntry(const char *text, size_t textLen) = 0;
+    };
+
+    /// @brief Pass the entries of the decrypted data of a batch frame on to `sink`.
+    ///        Nothing is passed on if its offset table is invalid.
+    /// @param entries Where the number of entries will be put.
+    /// @return `false` if the offset table is invalid.
+    bool writeBatchEntries(const unsigned char *plain, size_t plainLen,
+                           LogSink *sink, unsigned int *entries);
+
+    /// @brief Keeps entries in memory, to be passed on to another sink later.
+    class MemoryLogSink : public LogSink
+    {
+    private:
+        std::vector<char> text;
+        /// @brief Length (in bytes) of each entry in `text`.
+        std::vector<size_t> lengths;
+
+    public:
+        void writeEntry(const char *text, size_t textLen) override;
+
+        /// @brief Pass the entries on to `sink`, in the order they were written.
+        void replay(LogSink *sink);
+        /// @brief Length (in bytes) of the text of every entry held.
+        size_t getSize();
+    };
+
+    /// @brief How entries are laid out in a plain log file.
+    enum LogFileFormat
+    {
+        /// @brief A line break before every entry, as the logger writes them.
+        LogFileFormatLog,
+        /// @brief A line break after every entry (JSON Lines).
+        LogFileFormatJsonLines
+    };
+
+    /// @brief Parse the name of a log file format, either `"log"` or `"jsonl"`.
+    LogFileFormat parseLogFileFormat(const std::string &format);
+
+    /// @brief Suffix of plain log files in the given format.
+    const char *getLogFileSuffix(LogFileFormat format);
+
+    /// @brief Appends entries to a plain log file.
+    class FileLogSink : public LogSink
+    {
+    private:
+        FILE *file = nullptr;
+        unsigned long long size = 0;
+        LogFileFormat format = LogFileFormatLog;
+
+    public:
+        /// @param path Plain log file
+        /// @param keepLen Length (in bytes) of existing content to keep.
+        ///                Anything after it is discarded, so entries that
+        ///                were already written are not duplicated.
+        /// @param format How the entries are laid out.
+        FileLogSink(const std::filesystem::path &path, unsigned long long keepLen = 0,
+                    LogFileFormat format = LogFileFormatLog);
+        FileLogSink(const FileLogSink &) = delete;
+        FileLogSink &operator=(const FileLogSink &) = delete;
+        ~FileLogSink();
+
+        void writeEntry(const char *text, size_t textLen) override;
+
+        /// @brief Size (in bytes) of the file, including what has been written.
+        unsigned long long getSize();
+    };
+}
+
+#endif /* MAIN_LOG_READER */
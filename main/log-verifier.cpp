@@ -0,0 +1,208 @@
+#include <chrono>
+#include <exception>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "json.hpp"
+
+#include "dev-logger.h"
+#include "frame-buffer.h"
+#include "log-reader.h"
+#include "log-verifier.h"
+#include "logger.h"
+#include "work-stealing-pool.h"
+
+/// Length (in bytes) of the IV and of a block of an AES-CBC cipher.
+#define AES_CBC_BLOCK_LEN 16
+/// Length (in bytes) of the tag of an AES-GCM cipher.
+#define AES_GCM_TAG_LEN 16
+
+namespace
+{
+    /// @brief Counts decrypted entries that are not valid JSON.
+    class JsonCheckingSink : public logger::LogSink
+    {
+    public:
+        unsigned long long invalidEntries = 0;
+
+        void writeEntry(const char *text, size_t textLen) override
+        {
+            if (!nlohmann::json::accept(text, text + textLen))
+                this->invalidEntries++;
+        }
+    };
+}
+
+const char *logger::getVerificationStatusName(VerificationStatus status)
+{
+    switch (status)
+    {
+    case VerificationIntact:
+        return "intact";
+    case VerificationTornTail:
+        return "torn tail";
+    case VerificationCorrupt:
+        return "corrupt";
+    default:
+        return "unreadable";
+    }
+}
+
+bool logger::VerificationResult::isIntact() const
+{
+    return this->status == VerificationIntact && this->malformedFrames == 0 &&
+           this->orphanFrames == 0 && this->undecryptableKeys == 0 &&
+           this->undecryptableFrames == 0 && this->invalidEntries == 0;
+}
+
+/// @brief Walk the frames of a log file, checking each one,
+///        and decrypting them if there is a private key.
+static void walkFrames(logger::VerificationResult *result,
+                       const logger::VerificationOptions &options)
+{
+    using namespace logger;
+    LogReader reader(result->path);
+    result->validEnd = reader.getOffset();
+
+    std::unique_ptr<LogDecryptor> logDecryptor;
+    if (options.asymKey != nullptr)
+        logDecryptor.reset(new LogDecryptor(options.asymKey, options.keyCache));
+    JsonCheckingSink sink;
+    size_t keyLen = 0;
+    bool hasKey = false;
+
+    LogFrame frame;
+    while (true)
+    {
+        try
+        {
+            if (!(logDecryptor ? reader.next(&frame) : reader.nextHeader(&frame)))
+                break;
+        }
+        catch (const std::runtime_error &ex)
+        {
+            result->status = VerificationCorrupt;
+            result->error = ex.what();
+            return;
+        }
+        result->validEnd = reader.getOffset();
+
+        if (frame.type == DataTypeSymKey)
+        {
+            // Every key is wrapped with the same RSA key, so has the same length.
+            result->keyFrames++;
+            if (keyLen == 0)
+                keyLen = frame.dataLen;
+            if (frame.dataLen == 0 || frame.dataLen != keyLen || frame.compressed)
+                result->malformedFrames++;
+            hasKey = true;
+        }
+        else if (frame.type == DataTypeSegmentKey)
+        {
+            result->segmentKeyFrames++;
+            if (frame.dataLen != SEGMENT_NUMBER_LEN || frame.compressed ||
+                frame.version != ENC_LOGFILE_VERSION_GCM)
+                result->malformedFrames++;
+            if (!hasKey)
+            {
+                result->orphanFrames++;
+                continue;
+            }
+        }
+        else
+        {
+            // AES-CBC: an IV, followed by at least one padded block.
+            // AES-GCM: at least one byte (the entry count of a batch), followed by the tag.
+            result->entryFrames++;
+            size_t minPlainLen = frame.type == DataTypeJsonBatch ? BATCH_OFFSET_LEN : 1;
+            bool wellFormed = frame.version == ENC_LOGFILE_VERSION_GCM
+                                  ? frame.dataLen >= AES_GCM_TAG_LEN + minPlainLen
+                                  : frame.dataLen >= 2 * AES_CBC_BLOCK_LEN &&
+                                        frame.dataLen % AES_CBC_BLOCK_LEN == 0 && !frame.compressed;
+            if (!wellFormed)
+                result->malformedFrames++;
+            if (!hasKey)
+            {
+                result->orphanFrames++;
+                continue;
+            }
+        }
+
+        if (!logDecryptor)
+            continue;
+        try
+        {
+            if (!logDecryptor->decryptFrame(frame, &sink))
+                result->undecryptableFrames++;
+        }
+        catch (const std::exception &ex)
+        {
+            SPDERROR("Cannot unwrap key at byte {} of `{}`: {}",
+                     frame.offset, result->path.u8string(), ex.what());
+            result->undecryptableKeys++;
+        }
+    }
+
+    result->invalidEntries = sink.invalidEntries;
+    if (result->validEnd < result->bytes)
+    {
+        result->status = VerificationTornTail;
+        result->error = "Truncated frame at byte " + std::to_string(result->validEnd);
+    }
+}
+
+logger::VerificationResult logger::verifyLogFile(const std::filesystem::path &path,
+                                                 const VerificationOptions &options)
+{
+    auto start = std::chrono::steady_clock::now();
+    VerificationResult result;
+    result.path = path;
+    result.decrypted = options.asymKey != nullptr;
+
+    try
+    {
+        result.bytes = std::filesystem::file_size(path);
+        walkFrames(&result, options);
+    }
+    catch (const std::exception &ex)
+    {
+        result.status = VerificationUnreadable;
+        result.error = ex.what();
+    }
+
+    if (options.repair &&
+        (result.status == VerificationTornTail || result.status == VerificationCorrupt))
+    {
+        try
+        {
+            WARN("Truncate `{}` from {} to {} bytes", path.u8string(), result.bytes, result.validEnd);
+            std::filesystem::resize_file(path, result.validEnd);
+            result.repaired = true;
+        }
+        catch (const std::exception &ex)
+        {
+            SPDERROR("Cannot repair `{}`: {}", path.u8string(), ex.what());
+        }
+    }
+
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+std::vector<logger::VerificationResult> logger::verifyLogFiles(
+    const std::vector<std::filesystem::path> &paths,
+    const VerificationOptions &options)
+{
+    std::vector<VerificationResult> results(paths.size());
+    std::vector<std::function<void()>> tasks;
+    for (size_t i = 0; i < paths.size(); i++)
+        tasks.push_back([&results, &paths, &options, i]()
+                        { results[i] = verifyLogFile(paths[i], options); });
+
+    WorkStealingPool pool(options.threads);
+    pool.run(std::move(tasks));
+    return results;
+}
@@ -0,0 +1,89 @@
+#ifndef MAIN_LOG_VERIFIER
+#define MAIN_LOG_VERIFIER
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "crypto.h"
+#include "key-cache.h"
+
+namespace logger
+{
+    enum VerificationStatus
+    {
+        /// @brief Every frame is complete.
+        VerificationIntact,
+        /// @brief The file ends with a partly written frame, e.g. after a crash.
+        VerificationTornTail,
+        /// @brief A frame header is invalid, so no frame after it can be found.
+        VerificationCorrupt,
+        /// @brief The file cannot be read, or is not an encrypted log file.
+        VerificationUnreadable
+    };
+
+    /// @brief Name of a verification status, e.g. `"torn tail"`.
+    const char *getVerificationStatusName(VerificationStatus status);
+
+    struct VerificationOptions
+    {
+        /// @brief Private key to check that every entry decrypts,
+        ///        `nullptr` to only check the structure of the files.
+        crypto::AsymKey *asymKey = nullptr;
+        /// @brief Cache of unwrapped AES keys, `nullptr` to always unwrap them.
+        crypto::KeyCache *keyCache = nullptr;
+        /// @brief Truncate torn or corrupt files to their last complete frame.
+        ///        Whatever follows it is lost.
+        bool repair = false;
+        /// @brief Number of threads verifying files. `0` uses one per hardware thread.
+        unsigned int threads = 0;
+    };
+
+    struct VerificationResult
+    {
+        std::filesystem::path path;
+        VerificationStatus status = VerificationIntact;
+        /// @brief Size (in bytes) of the file, before any repair.
+        unsigned long long bytes = 0;
+        /// @brief Offset (in bytes) right after the last complete frame.
+        unsigned long long validEnd = 0;
+        unsigned long long keyFrames = 0;
+        /// @brief Frames switching to a key derived from the last key frame.
+        unsigned long long segmentKeyFrames = 0;
+        /// @brief Frames holding a single entry, or a batch of them.
+        unsigned long long entryFrames = 0;
+        /// @brief Frames too short, or of a length no cipher can have.
+        unsigned long long malformedFrames = 0;
+        /// @brief Entry and segment key frames that precede any key frame.
+        unsigned long long orphanFrames = 0;
+        /// @brief Were the entries decrypted to check them?
+        bool decrypted = false;
+        /// @brief Key frames that could not be unwrapped, or derived.
+        unsigned long long undecryptableKeys = 0;
+        /// @brief Entry frames that could not be decrypted. In AES-GCM files,
+        ///        it includes entries whose data or header was tampered with.
+        unsigned long long undecryptableFrames = 0;
+        /// @brief Entries that decrypted to something other than JSON.
+        unsigned long long invalidEntries = 0;
+        /// @brief Was the file truncated to its last complete frame?
+        bool repaired = false;
+        /// @brief What is wrong with the structure of the file, empty if nothing.
+        std::string error;
+        double seconds = 0;
+
+        /// @brief Is the file complete, and is every frame in it usable?
+        bool isIntact() const;
+    };
+
+    /// @brief Check an encrypted log file by walking its frame headers,
+    ///        without decrypting anything unless `options.asymKey` is set.
+    ///        Only headers are read then, so it runs at disk speed.
+    VerificationResult verifyLogFile(const std::filesystem::path &path,
+                                     const VerificationOptions &options = {});
+
+    /// @brief Check encrypted log files in parallel.
+    /// @return One result per file, in the order of `paths`.
+    std::vector<VerificationResult> verifyLogFiles(const std::vector<std::filesystem::path> &paths,
+                                                   const VerificationOptions &options = {});
+}
+
+#endif /* MAIN_LOG_VERIFIER */
@@ -0,0 +1,179 @@
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <ios>
+#include <stdexcept>
+#include <string>
+#include <time.h>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "dev-logger.h"
+#include "log-reader.h"
+#include "log-writer.h"
+
+/// Size (in bytes) of the stdio buffer behind an open log file.
+#define LOG_WRITER_BUFFER_SIZE 65536
+
+logger::FlushPolicy logger::parseFlushPolicy(const std::string &policy)
+{
+    if (policy == "entry")
+        return FlushPerEntry;
+    if (policy == "count")
+        return FlushEveryNEntries;
+    if (policy == "interval")
+        return FlushEveryInterval;
+    throw std::invalid_argument("Unknown flush policy `" + policy + "`");
+}
+
+logger::LogWriter::LogWriter(std::filesystem::path outDir,
+                             std::string suffix,
+                             bool binary,
+                             const FlushConfig &flushConfig)
+    : outDir(outDir), suffix(suffix), binary(binary)
+{
+    this->flushPolicy = parseFlushPolicy(flushConfig.policy);
+    this->flushEntries = flushConfig.entries == 0 ? 1 : flushConfig.entries;
+    this->flushInterval = std::chrono::seconds(flushConfig.interval);
+    this->syncInterval = std::chrono::seconds(flushConfig.syncInterval);
+    this->lastFlush = this->lastSync = std::chrono::steady_clock::now();
+}
+
+/// @brief Date (in YYYYMMDD format) of the log file of a timestamp.
+static std::string getLogFileDate(time_t timestamp)
+{
+    char outBuffer[10];
+    strftime(outBuffer, sizeof(outBuffer), "%Y%m%d", localtime(&timestamp));
+    return outBuffer;
+}
+
+logger::LogFileStatus logger::LogWriter::open(time_t timestamp)
+{
+    std::string date = getLogFileDate(timestamp);
+    if (this->file != nullptr && this->currentDate == date)
+        return LogFileUnchanged;
+
+    this->close();
+    this->currentDate = date;
+    this->currentPath = this->outDir / std::filesystem::path(this->currentDate + this->suffix);
+    DEBUG("Open log file `{}`", this->currentPath.u8string());
+
+    // A frame cut short by a crash would swallow the frames appended after it.
+    // Frames are length-prefixed, so cutting it off recovers every complete one.
+    if (this->binary)
+    {
+        try
+        {
+            trimTornTail(this->currentPath);
+        }
+        catch (const std::exception &ex)
+        {
+            SPDERROR("Cannot check the end of log file `{}`: {}", this->currentPath.u8string(), ex.what());
+        }
+    }
+
+#ifdef _WIN32
+    this->file = _wfopen(this->currentPath.c_str(), this->binary ? L"ab" : L"a");
+#else
+    this->file = std::fopen(this->currentPath.c_str(), this->binary ? "ab" : "a");
+#endif
+    if (this->file == nullptr)
+        throw std::ios_base::failure(std::strerror(errno));
+
+    std::setvbuf(this->file, nullptr, _IOFBF, LOG_WRITER_BUFFER_SIZE);
+
+    // Checking the size of the opened file spares us
+    // a separate `std::filesystem::exists` call.
+    std::fseek(this->file, 0, SEEK_END);
+    if (std::ftell(this->file) == 0)
+    {
+        DEBUG("Created log file for the day");
+        return LogFileCreated;
+    }
+    return LogFileOpened;
+}
+
+bool logger::LogWriter::isOpen(time_t timestamp)
+{
+    return this->file != nullptr && this->currentDate == getLogFileDate(timestamp);
+}
+
+void logger::LogWriter::write(const void *data, size_t dataLen)
+{
+    assert(this->file != nullptr);
+    if (std::fwrite(data, 1, dataLen, this->file) != dataLen)
+        throw std::ios_base::failure(std::strerror(errno));
+}
+
+void logger::LogWriter::commit()
+{
+    this->entriesSinceFlush++;
+
+    switch (this->flushPolicy)
+    {
+    case FlushPerEntry:
+        this->flush();
+        break;
+    case FlushEveryNEntries:
+        if (this->entriesSinceFlush >= this->flushEntries)
+            this->flush();
+        break;
+    case FlushEveryInterval:
+        if (std::chrono::steady_clock::now() - this->lastFlush >= this->flushInterval)
+            this->flush();
+        break;
+    }
+}
+
+void logger::LogWriter::flush()
+{
+    auto now = std::chrono::steady_clock::now();
+    if (this->file != nullptr)
+    {
+        std::fflush(this->file);
+        if (this->syncInterval.count() > 0 && now - this->lastSync >= this->syncInterval)
+            this->sync();
+    }
+    this->entriesSinceFlush = 0;
+    this->lastFlush = now;
+}
+
+void logger::LogWriter::sync()
+{
+#ifdef _WIN32
+    int result = _commit(_fileno(this->file));
+#else
+    int result = fsync(fileno(this->file));
+#endif
+    if (result != 0)
+        SPDERROR("Cannot sync log file `{}`: {}", this->currentPath.u8string(), std::strerror(errno));
+    this->lastSync = std::chrono::steady_clock::now();
+}
+
+void logger::LogWriter::close()
+{
+    if (this->file == nullptr)
+        return;
+
+    DEBUG("Close log file `{}`", this->currentPath.u8string());
+    if (this->syncInterval.count() > 0 && std::fflush(this->file) == 0)
+        this->sync();
+    std::fclose(this->file);
+    this->file = nullptr;
+    this->entriesSinceFlush = 0;
+}
+
+const std::filesystem::path &logger::LogWriter::getPath()
+{
+    return this->currentPath;
+}
+
+logger::LogWriter::~LogWriter()
+{
+    this->close();
+}
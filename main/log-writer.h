@@ -0,0 +1,93 @@
+#ifndef MAIN_LOG_WRITER
+#define MAIN_LOG_WRITER
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <time.h>
+
+#include "config.h"
+
+namespace logger
+{
+    enum FlushPolicy
+    {
+        FlushPerEntry,
+        FlushEveryNEntries,
+        FlushEveryInterval
+    };
+
+    /// @brief Convert the `flush.policy` config value into a `FlushPolicy`.
+    ///        Throws `std::invalid_argument` on unknown values.
+    FlushPolicy parseFlushPolicy(const std::string &policy);
+
+    enum LogFileStatus
+    {
+        /// @brief The same day file is still open.
+        LogFileUnchanged,
+        /// @brief An existing day file has been opened.
+        LogFileOpened,
+        /// @brief A new, empty day file has been created.
+        LogFileCreated
+    };
+
+    /// @brief Long-lived writer that keeps the current day file open,
+    ///        and only switches files when the date changes.
+    class LogWriter
+    {
+    private:
+        std::filesystem::path outDir;
+        std::string suffix;
+        bool binary = false;
+
+        FlushPolicy flushPolicy = FlushPerEntry;
+        unsigned int flushEntries = 1;
+        std::chrono::seconds flushInterval{0};
+        /// @brief Least time between syncs to the disk, `0` to never sync.
+        std::chrono::seconds syncInterval{0};
+
+        std::FILE *file = nullptr;
+        /// @brief The date (in YYYYMMDD format) of the open file.
+        std::string currentDate;
+        std::filesystem::path currentPath;
+
+        unsigned int entriesSinceFlush = 0;
+        std::chrono::steady_clock::time_point lastFlush;
+        std::chrono::steady_clock::time_point lastSync;
+
+        /// @brief Ask the operating system to put what has been flushed on the disk.
+        void sync();
+
+    public:
+        /// @param outDir Log directory
+        /// @param suffix Suffix appended to the `YYYYMMDD` file name
+        /// @param binary Is it an encrypted log file, opened in binary mode?
+        ///               A torn frame it ends with is trimmed when it is opened.
+        /// @param flushConfig When to flush buffered entries
+        LogWriter(std::filesystem::path outDir,
+                  std::string suffix,
+                  bool binary,
+                  const FlushConfig &flushConfig);
+        ~LogWriter();
+
+        /// @brief Make sure the log file for the day of `timestamp` is open.
+        ///        Only touches the file system when the date has changed.
+        /// @param timestamp Unix timestamp
+        LogFileStatus open(time_t timestamp);
+        /// @brief Is the log file for the day of `timestamp` the one open?
+        bool isOpen(time_t timestamp);
+
+        void write(const void *data, size_t dataLen);
+
+        /// @brief Mark the end of an entry, and flush if the policy says so.
+        void commit();
+        /// @brief Flush buffered entries, and sync them to the disk
+        ///        if the sync interval has passed.
+        void flush();
+        void close();
+
+        const std::filesystem::path &getPath();
+    };
+}
+
+#endif /* MAIN_LOG_WRITER */
@@ -1,53 +1,69 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
 #include <filesystem>
 #include <fstream>
+#include <functional>
 #include <map>
 #include <time.h>
 
 #include "capturer.h"
+#include "compression.h"
 #include "config.h"
 #include "dev-logger.h"
 #include "helpers.h"
 #include "json.hpp"
 #include "logger.h"
+#include "work-stealing-pool.h"
 
-#define ENC_LOGFILE_VERSION 'A'
 #define ENC_LOGFILE_SUFFIX ".json.log.enc"
 #define LOGFILE_SUFFIX ".json.log"
-#define ENC_LOGFILE_REGEX_PATTERN "\\d{8}\\.json\\.log\\.enc"
 #define LOGFILE_BASE_NAME_PATTERN "\\d{8}"
-
-const std::map<unsigned char, logger::DataType> BYTE_TO_DATA_TYPE{
-    {0, logger::DataTypeJson},
-    {1, logger::DataTypeSymKey}};
+/// Minimum length (in bytes) of a chunk of log file decrypted by a single task.
+#define DECRYPTION_CHUNK_MIN_LEN 1048576
+/// Maximum length (in bytes) of the plaintext of the chunks decrypted in parallel before being written out.
+#define DECRYPTION_BATCH_MAX_LEN 67108864
+/// Assumed bytes of plaintext per byte of encrypted data, until a batch has been decrypted.
+/// Deflate shrinks batches of log entries up to about this much, so the first batch errs on the small side.
+#define DECRYPTION_EXPANSION_GUESS 32
+/// Number of chunks per thread in a batch.
+#define DECRYPTION_CHUNKS_PER_THREAD 4
+/// Most bytes of entry text in a batch frame, leaving room in the frame for the offset table.
+#define BATCH_MAX_TEXT_LEN (FRAME_MAX_DATA_LEN / 2)
 
 /// @brief Capture a snapshot
+/// @param captureSource Where the opened apps come from
 /// @param timestamp UNIX timestamp
-/// @return Snapshot
-nlohmann::json generateBasicLogEntry(time_t timestamp)
+/// @param entry Where the snapshot will be put
+/// @param activeApp Where the active app will be put (if there is one)
+void generateBasicLogEntry(CaptureSource *captureSource,
+                           time_t timestamp,
+                           LogEntry *entry,
+                           AppRecord *activeApp)
 {
-    nlohmann::json entry;
-    entry["time"] = timestamp;
-
-    std::vector<AppRecord> apps;
-    getOpenedApps(&apps);
+    entry->type = LogEntrySnapshot;
+    entry->timestamp = timestamp;
+    entry->apps.clear();
+    captureSource->getOpenedApps(&entry->apps);
 
-    entry["apps"] = nlohmann::json::array();
-
-    for (auto const &appRecord : apps)
-    {
-        entry["apps"].push_back({{"title", appRecord.title},
-                                 {"path", appRecord.path}});
+    if (activeApp == nullptr)
+        return;
+    for (auto const &appRecord : entry->apps)
         if (appRecord.isActive)
-            entry["apps"].back()["isActive"] = true;
-    };
-
-    return entry;
+            *activeApp = appRecord;
 }
 
 logger::Logger::Logger(Config *config)
 {
     this->config = config;
+    this->captureSource = createCaptureSource(config);
     this->outDir = prepareAndProcessPath(config->outDir, true, true);
+    this->writer = new LogWriter(
+        this->outDir,
+        config->encryption.enabled ? ENC_LOGFILE_SUFFIX : LOGFILE_SUFFIX,
+        config->encryption.enabled,
+        config->flush);
 
     if (config->encryption.enabled)
     {
@@ -57,141 +73,345 @@ logger::Logger::Logger(Config *config)
 
         if (!this->asymKey->validate(crypto::KeyTypePublic))
             throw crypto::CryptoError("Invalid public key");
+
+        if (config->encryption.compressionLevel > 0)
+            this->compressor = new Compressor(config->encryption.compressionLevel);
     }
 };
 
 void logger::Logger::captureAndAppend()
 {
     time_t timestamp = time(nullptr);
-    char outBuffer[32];
-    std::string logPath = this->prepareLogFile(timestamp);
+    this->arena.reset();
+    LogEntry logEntry(this->arena.resource());
+    this->capture(timestamp, &logEntry);
+    this->write(logEntry);
+}
 
-    auto logEntry = this->capture(timestamp, getDurationSinceLastInput());
+void logger::Logger::write(const LogEntry &logEntry)
+{
+    this->prepareLogFile(logEntry.timestamp);
 
     if (this->config->encryption.enabled)
     {
         if (this->rotatingSymKey == nullptr)
-            this->generateAndAppendSymKey(logPath);
+            this->generateAndAppendSymKey();
         else if (this->logsSinceLatestKeyGen >= this->config->encryption.keyGenRate)
         {
-            this->generateAndAppendSymKey(logPath);
+            this->rotateSymKey();
             this->logsSinceLatestKeyGen = 0;
         }
         else
             this->logsSinceLatestKeyGen++;
     }
 
-    this->append(logEntry, logPath, this->config->encryption.enabled);
+    this->append(logEntry, this->config->encryption.enabled);
 }
 
-nlohmann::json logger::Logger::capture(time_t timestamp, unsigned int durationSinceLastInput)
+void logger::Logger::capture(time_t timestamp, LogEntry *entry)
 {
-    nlohmann::json entry;
+    this->capture(timestamp, this->captureSource->getDurationSinceLastInput(), entry);
+}
 
+void logger::Logger::capture(time_t timestamp, unsigned int durationSinceLastInput, LogEntry *entry)
+{
     if (durationSinceLastInput > this->config->idleThreshold)
     {
         DEBUG("User is away. Last input is {} seconds ago.", durationSinceLastInput);
-        entry["timestamp"] = timestamp;
-        entry["durationSinceLastInput"] = durationSinceLastInput;
+        entry->type = LogEntryIdle;
+        entry->timestamp = timestamp;
+        entry->durationSinceLastInput = durationSinceLastInput;
+        this->lastFocusIdle = true;
     }
     else
-        entry = generateBasicLogEntry(timestamp);
+    {
+        // Cleared rather than replaced, so the strings keep their capacity,
+        // and copying the active app into them does not allocate.
+        this->lastFocus.path.clear();
+        this->lastFocus.title.clear();
+        this->lastFocus.isActive = false;
+        generateBasicLogEntry(this->captureSource, timestamp, entry, &this->lastFocus);
+        this->lastFocusIdle = false;
+    }
+    this->lastFocusKnown = true;
+}
 
-    return entry;
+bool logger::Logger::captureFocus(time_t timestamp, LogEntry *entry)
+{
+    unsigned int durationSinceLastInput = this->captureSource->getDurationSinceLastInput();
+
+    if (durationSinceLastInput > this->config->idleThreshold)
+    {
+        if (this->lastFocusKnown && this->lastFocusIdle)
+            return false;
+
+        this->capture(timestamp, durationSinceLastInput, entry);
+        return true;
+    }
+
+    // Without a foreground app (e.g. on the lock screen, or a source
+    // that cannot tell), the focus is unknown rather than changed.
+    AppRecord &app = this->probedFocus;
+    if (!this->captureSource->getForegroundApp(&app))
+        return false;
+
+    if (this->lastFocusKnown && !this->lastFocusIdle &&
+        app.path == this->lastFocus.path && app.title == this->lastFocus.title)
+        return false;
+
+    DEBUG("Focus changed to `{}`", app.path);
+    entry->type = LogEntryFocus;
+    entry->timestamp = timestamp;
+    entry->focus = app;
+
+    // Copied into the existing strings, reusing their capacity.
+    this->lastFocus = app;
+    this->lastFocusKnown = true;
+    this->lastFocusIdle = false;
+    return true;
 }
 
-void logger::Logger::append(nlohmann::json entry, std::string logPath, bool encryptedBinary)
+void logger::Logger::append(const LogEntry &entry, bool encryptedBinary)
 {
     if (!encryptedBinary)
     {
-        std::ofstream logFile(logPath, std::ios::out | std::ios_base::app);
-        logFile << "\n"
-                << entry.dump();
+        this->frame.reset();
+        this->frame.append("\n", 1);
+        this->frame.append(entry);
+        this->writer->write(this->frame.data(), this->frame.size());
+        this->writer->commit();
         return;
     }
 
-    std::ofstream logFile(logPath, std::ios::binary | std::ios::out | std::ios_base::app);
-
     assert(this->rotatingSymKey != nullptr);
 
-    std::string jsonStr(entry.dump());
+    // Batch frames only exist in AES-GCM files, older readers do not know them.
+    if (this->fileVersion == ENC_LOGFILE_VERSION_GCM && this->config->batch.entries > 1)
+    {
+        this->appendToBatch(entry);
+        return;
+    }
 
-    size_t cipherLen = this->rotatingSymKey->calculateCipherLen(jsonStr.size());
-    unsigned char cipher[cipherLen];
+    if (this->fileVersion == ENC_LOGFILE_VERSION_GCM)
+    {
+        // The JSON text is serialized right after the frame header, and encrypted in place.
+        this->frame.reset(FRAME_HEADER_LEN);
+        this->frame.append(entry);
+        this->writeAuthenticated(&this->frame, DataTypeJson);
+        return;
+    }
+
+    // The JSON text is serialized right after the space reserved for
+    // the frame header and the IV, and then encrypted in place.
+    size_t reservedLen = FRAME_HEADER_LEN + this->rotatingSymKey->getIvLen();
+    this->frame.reset(reservedLen);
+    this->frame.append(entry);
 
-    this->rotatingSymKey->encrypt(
-        (unsigned char *)jsonStr.c_str(),
-        jsonStr.size(),
-        &cipher[0],
+    size_t plainLen = this->frame.size() - reservedLen;
+    size_t cipherLen = this->rotatingSymKey->calculateCipherLen(plainLen);
+    this->frame.resize(FRAME_HEADER_LEN + cipherLen);
+
+    this->rotatingSymKey->encryptInPlace(
+        (unsigned char *)this->frame.data() + FRAME_HEADER_LEN,
+        plainLen,
         cipherLen);
 
-    this->appendBinary(DataTypeJson, &cipher[0], cipherLen, &logFile);
+    this->frame.sealHeader(DataTypeJson);
+    this->writer->write(this->frame.data(), this->frame.size());
+    this->writer->commit();
+}
+
+void logger::Logger::writeAuthenticated(FrameBuffer *buffer, DataType type)
+{
+    size_t plainLen = buffer->size() - FRAME_HEADER_LEN;
+    bool compressed = false;
+    if (this->compressor != nullptr)
+    {
+        auto &deflated = this->compressor->compress(
+            reinterpret_cast<unsigned char *>(buffer->data()) + FRAME_HEADER_LEN, plainLen);
+        // Short entries may not shrink, they are kept as they are.
+        if (deflated.size() < plainLen)
+        {
+            buffer->reset(FRAME_HEADER_LEN);
+            buffer->append(deflated.data(), deflated.size());
+            plainLen = deflated.size();
+            compressed = true;
+        }
+    }
+
+    // The header is sealed first, as it is authenticated.
+    buffer->resize(FRAME_HEADER_LEN + plainLen + this->rotatingSymKey->getTagLen());
+    buffer->sealHeader(type, compressed);
+
+    auto data = reinterpret_cast<unsigned char *>(buffer->data());
+    this->rotatingSymKey->encryptAuthenticated(data + FRAME_HEADER_LEN, plainLen,
+                                               this->nonceCounter++,
+                                               data, FRAME_HEADER_LEN);
+    this->writer->write(buffer->data(), buffer->size());
+    this->writer->commit();
 }
 
-void logger::Logger::appendBinary(logger::DataType type, unsigned char *data,
-                                  size_t dataLen, std::ofstream *fileStream)
+void logger::Logger::appendToBatch(const LogEntry &entry)
 {
-    if (dataLen > 16777215)
-        throw std::runtime_error("Data exceeds supported length of 16 megabytes");
+    if (this->batchEnds.empty())
+    {
+        this->batch.reset(FRAME_HEADER_LEN);
+        this->batchStart = std::chrono::steady_clock::now();
+    }
 
-    unsigned char entryLen[3] = {
-        static_cast<unsigned char>(dataLen >> 16),
-        static_cast<unsigned char>(dataLen >> 8),
-        static_cast<unsigned char>(dataLen >> 0)};
+    this->batch.append(entry);
+    size_t textLen = this->batch.size() - FRAME_HEADER_LEN;
+    this->batchEnds.push_back(textLen);
 
-    fileStream->write((char *)&type, 1);
-    fileStream->write((char *)entryLen, sizeof entryLen);
-    fileStream->write((char *)data, dataLen);
+    auto &batchConfig = this->config->batch;
+    if (this->batchEnds.size() >= batchConfig.entries ||
+        textLen >= std::min<size_t>(batchConfig.bytes, BATCH_MAX_TEXT_LEN) ||
+        std::chrono::steady_clock::now() - this->batchStart >= std::chrono::seconds(batchConfig.maxAge))
+        this->commitBatch();
+}
+
+void logger::Logger::commitBatch()
+{
+    if (this->batchEnds.empty())
+        return;
+
+    DEBUG("Write batch of {} entries", this->batchEnds.size());
+    for (size_t end : this->batchEnds)
+        this->batch.appendOffset(end);
+    this->batch.appendOffset(this->batchEnds.size());
+    this->batchEnds.clear();
+
+    this->writeAuthenticated(&this->batch, DataTypeJsonBatch);
+}
+
+void logger::Logger::commitBatchIfDue()
+{
+    if (!this->batchEnds.empty() &&
+        std::chrono::steady_clock::now() - this->batchStart >= std::chrono::seconds(this->config->batch.maxAge))
+        this->commitBatch();
+}
+
+void logger::Logger::flush()
+{
+    this->commitBatch();
+    this->writer->flush();
+}
+
+void logger::Logger::appendBinary(logger::DataType type, unsigned char *data, size_t dataLen)
+{
+    this->frame.reset(FRAME_HEADER_LEN);
+    this->frame.append((char *)data, dataLen);
+    this->frame.sealHeader(type);
+    this->writer->write(this->frame.data(), this->frame.size());
 };
 
-std::string logger::Logger::prepareLogFile(time_t timestamp)
+void logger::Logger::prepareLogFile(time_t timestamp)
 {
-    char outBuffer[10];
-    strftime(outBuffer, sizeof(outBuffer), "%Y%m%d", localtime(&timestamp));
-    std::string date(outBuffer);
-    DEBUG("Prepare log file at timestamp {} and date {}", timestamp, date);
+    // Batched entries go to the file of the day they were captured.
+    if (!this->batchEnds.empty() && !this->writer->isOpen(timestamp))
+        this->commitBatch();
 
-    if (!config->encryption.enabled)
-        return (this->outDir / std::filesystem::path(date + LOGFILE_SUFFIX)).u8string();
+    auto status = this->writer->open(timestamp);
+    if (status == LogFileUnchanged || !config->encryption.enabled)
+        return;
 
-    auto logPath = this->outDir / std::filesystem::path(date + ENC_LOGFILE_SUFFIX);
-    if (std::filesystem::exists(logPath))
+    DEBUG("Prepare log file at timestamp {}", timestamp);
+    if (status == LogFileCreated)
     {
-        DEBUG("Encrypted log file for the day already exists.");
-        return logPath.u8string();
+        DEBUG("Put a version specifier on the first byte");
+        this->fileVersion = ENC_LOGFILE_VERSION;
+        this->writer->write(&this->fileVersion, 1);
+    }
+    else
+    {
+        try
+        {
+            this->fileVersion = readLogFileVersion(this->writer->getPath());
+        }
+        catch (const std::exception &ex)
+        {
+            SPDERROR("Append to log file with an unknown version: {}", ex.what());
+            this->fileVersion = ENC_LOGFILE_VERSION;
+        }
     }
 
-    DEBUG("Create encrypted log file for the day");
-    this->lastAppendDate = date;
-    std::ofstream f(logPath, std::ios::binary | std::ios::out | std::ios_base::app);
+    // AES-GCM nonces count from the key frame, so a key
+    // is never carried over to another file.
+    if (this->rotatingSymKey != nullptr)
+    {
+        DEBUG("Append new sym key on new log file");
+        this->generateAndAppendSymKey();
+        this->logsSinceLatestKeyGen = 0;
+    }
+}
 
-    DEBUG("Put a version specifier on the first byte");
-    char logfileVersion = ENC_LOGFILE_VERSION;
-    f.write(&logfileVersion, 1);
+/// @brief Create a SymKey with the same secret.
+static crypto::SymKey *copySymKey(crypto::SymKey *symKey)
+{
+    std::vector<CryptoPP::byte> secret(symKey->getSecretLen());
+    symKey->getSecret(secret.data(), secret.size());
+    return new crypto::SymKey(secret.data(), secret.size());
+}
 
-    if (this->rotatingSymKey != nullptr)
+/// @brief Write the big-endian segment number of a segment key frame.
+static void writeSegmentNumber(unsigned long long segment, unsigned char *data)
+{
+    for (int i = SEGMENT_NUMBER_LEN - 1; i >= 0; i--)
     {
-        DEBUG("Append sym key on new log file");
-        this->appendSymKey(&f);
+        data[i] = static_cast<unsigned char>(segment);
+        segment >>= 8;
     }
+}
 
-    return logPath.u8string();
+/// @brief Read the big-endian segment number of a segment key frame.
+static unsigned long long readSegmentNumber(const unsigned char *data)
+{
+    unsigned long long segment = 0;
+    for (int i = 0; i < SEGMENT_NUMBER_LEN; i++)
+        segment = (segment << 8) | data[i];
+    return segment;
 }
 
-void logger::Logger::generateAndAppendSymKey(std::ofstream *fileStream)
+void logger::Logger::generateAndAppendSymKey()
 {
+    // Batched entries are encrypted with the key they were captured under.
+    this->commitBatch();
+
     delete this->rotatingSymKey;
     this->rotatingSymKey = new crypto::SymKey();
     this->rotatingSymKey->generateRandom();
-    this->appendSymKey(fileStream);
+    this->nonceCounter = 0;
+    this->appendSymKey();
+
+    delete this->fileKey;
+    this->fileKey = copySymKey(this->rotatingSymKey);
+    this->segment = 0;
 }
-void logger::Logger::generateAndAppendSymKey(std::string logPath)
+
+void logger::Logger::rotateSymKey()
 {
-    std::ofstream f(logPath, std::ios::binary | std::ios::out | std::ios_base::app);
-    this->generateAndAppendSymKey(&f);
+    // Files made by older versions only know RSA-wrapped keys.
+    if (this->fileVersion != ENC_LOGFILE_VERSION_GCM || this->fileKey == nullptr)
+    {
+        this->generateAndAppendSymKey();
+        return;
+    }
+
+    // Batched entries are encrypted with the key they were captured under.
+    this->commitBatch();
+
+    this->segment++;
+    DEBUG("Derive key of segment {}", this->segment);
+    delete this->rotatingSymKey;
+    this->rotatingSymKey = this->fileKey->deriveSegmentKey(this->segment);
+    this->nonceCounter = 0;
+
+    unsigned char segmentNumber[SEGMENT_NUMBER_LEN];
+    writeSegmentNumber(this->segment, segmentNumber);
+    this->appendBinary(DataTypeSegmentKey, segmentNumber, SEGMENT_NUMBER_LEN);
 }
 
-void logger::Logger::appendSymKey(std::ofstream *fileStream)
+void logger::Logger::appendSymKey()
 {
     size_t secretLen = this->rotatingSymKey->getSecretLen();
     unsigned char secret[secretLen];
@@ -202,132 +422,656 @@ void logger::Logger::appendSymKey(std::ofstream *fileStream)
 
     this->asymKey->encrypt(secret, secretLen, &cipher[0], cipherLen);
 
-    this->appendBinary(DataTypeSymKey, &cipher[0], cipherLen, fileStream);
+    this->appendBinary(DataTypeSymKey, &cipher[0], cipherLen);
 }
 
 logger::Logger::~Logger()
 {
+    try
+    {
+        this->commitBatch();
+    }
+    catch (const std::exception &ex)
+    {
+        SPDERROR("Failed to write batched log entries: {}", ex.what());
+    }
+
+    delete this->captureSource;
+    delete this->writer;
     delete this->asymKey;
     delete this->rotatingSymKey;
+    delete this->fileKey;
+    delete this->compressor;
 }
 
-logger::LogDecryptor::LogDecryptor(crypto::AsymKey *asymKey) : asymKey(asymKey) {}
+logger::LogDecryptor::LogDecryptor(crypto::AsymKey *asymKey, crypto::KeyCache *keyCache)
+    : asymKey(asymKey), keyCache(keyCache) {}
 
-void logger::LogDecryptor::decrypt(CryptoPP::byte *cipher,
-                                   size_t cipherLen,
-                                   CryptoPP::byte *plain,
-                                   size_t plainLen,
-                                   size_t *outputLen)
+bool logger::LogDecryptor::decryptFrame(const LogFrame &frame, LogSink *sink, unsigned int *entries)
 {
-    assert(plainLen >= cipherLen);
+    DEBUG("Byte position: {}; data length: {};", frame.offset, frame.dataLen);
+    if (entries != nullptr)
+        *entries = 0;
 
-    CryptoPP::byte *pCipher = cipher;
-    CryptoPP::byte *pPlain = plain;
+    if (frame.type == DataTypeSymKey)
+    {
+        DEBUG("Load sym key");
+        delete this->rotatingSymKey;
+        this->rotatingSymKey = nullptr;
+        delete this->fileKey;
+        this->fileKey = nullptr;
+        this->rotatingSymKey = this->newSymKeyFromData(frame.data, frame.dataLen);
+        this->fileKey = copySymKey(this->rotatingSymKey);
+        this->nonceCounter = 0;
+        return true;
+    }
 
-    CryptoPP::byte *pCipherEnd = pCipher + cipherLen - 1;
-    crypto::SymKey *rotatingSymKey = nullptr;
+    if (frame.type == DataTypeSegmentKey)
+    {
+        if (this->fileKey == nullptr || frame.dataLen != SEGMENT_NUMBER_LEN)
+            throw std::runtime_error("Segment key frame at byte " + std::to_string(frame.offset) +
+                                     " has no key to derive from");
+
+        auto segment = readSegmentNumber(frame.data);
+        DEBUG("Derive key of segment {}", segment);
+        delete this->rotatingSymKey;
+        this->rotatingSymKey = this->fileKey->deriveSegmentKey(segment);
+        this->nonceCounter = 0;
+        return true;
+    }
+
+    // Skipped entries and entries that fail to decrypt
+    // still count towards the nonce.
+    unsigned long long counter = this->nonceCounter++;
+    if (sink == nullptr)
+        return true;
+
+    if (this->rotatingSymKey == nullptr)
+    {
+        SPDERROR("Log entry at byte {} precedes any key, skip it", frame.offset);
+        return false;
+    }
+
+    DEBUG("Decrypt data");
+    this->plain.resize(frame.dataLen);
+    size_t outputLen = 0;
+    try
+    {
+        if (frame.version == ENC_LOGFILE_VERSION_GCM)
+        {
+            unsigned char header[FRAME_HEADER_LEN];
+            encodeFrameHeader(frame.type, frame.dataLen, header, frame.compressed);
+            outputLen = this->rotatingSymKey->decryptAuthenticated(
+                frame.data, frame.dataLen, counter, header, FRAME_HEADER_LEN,
+                this->plain.data(), this->plain.size());
+        }
+        else
+            this->rotatingSymKey->decrypt(frame.data, frame.dataLen,
+                                          this->plain.data(), this->plain.size(),
+                                          &outputLen);
+    }
+    catch (const crypto::DecryptionError &ex)
+    {
+        SPDERROR(ex.what());
+        return false;
+    }
 
-    char versionSpecifier = *pCipher;
-    pCipher++;
+    const unsigned char *text = this->plain.data();
+    if (frame.compressed)
+    {
+        if (!inflateData(this->plain.data(), outputLen, FRAME_MAX_DATA_LEN, &this->inflated))
+        {
+            SPDERROR("Log entry at byte {} cannot be decompressed, skip it", frame.offset);
+            return false;
+        }
+        text = reinterpret_cast<const unsigned char *>(this->inflated.data());
+        outputLen = this->inflated.size();
+    }
 
-    if (versionSpecifier != 'A')
-        throw std::runtime_error("Invalid version specifier in log data.");
+    if (frame.type == DataTypeJsonBatch)
+    {
+        unsigned int batchEntries = 0;
+        if (!writeBatchEntries(text, outputLen, sink, &batchEntries))
+        {
+            SPDERROR("Batch of log entries at byte {} has an invalid offset table, skip it", frame.offset);
+            return false;
+        }
+        if (entries != nullptr)
+            *entries = batchEntries;
+        return true;
+    }
 
-    logger::DataType dataType;
-    unsigned long int dataLen = 0;
+    sink->writeEntry(reinterpret_cast<const char *>(text), outputLen);
+    if (entries != nullptr)
+        *entries = 1;
+    return true;
+}
 
-    DEBUG("Begin decryption loop");
+unsigned long long logger::LogDecryptor::decryptSegment(LogReader *reader,
+                                                       const LogSegment &segment,
+                                                       LogSink *sink,
+                                                       DecryptionProgress *progress)
+{
+    LogFrame frame;
+    unsigned long long entries = 0;
 
-    while (pCipher < pCipherEnd)
+    reader->seek(segment.begin);
+    while (reader->getOffset() < segment.end && reader->next(&frame))
     {
-        dataType = BYTE_TO_DATA_TYPE.at(*pCipher);
-        pCipher++;
+        unsigned int frameEntries = 0;
+        this->decryptFrame(frame, sink, &frameEntries);
+        entries += frameEntries;
+        if (frame.type == DataTypeSymKey)
+            progress->keyOffset = frame.offset;
+        progress->offset = reader->getOffset();
+        progress->frames++;
+    }
+    return entries;
+}
 
-        dataLen = (pCipher[2] << 0) | (pCipher[1] << 8) | (pCipher[0] << 16);
-        pCipher += 3;
+/// @brief Load the key of the key frame at `keyOffset`.
+static void loadKeyFrame(logger::LogDecryptor *logDecryptor,
+                         logger::LogReader *reader,
+                         unsigned long long keyOffset)
+{
+    logger::LogFrame frame;
+    reader->seek(keyOffset);
+    if (!reader->next(&frame) || frame.type != logger::DataTypeSymKey)
+        throw std::runtime_error("No key frame at byte " + std::to_string(keyOffset));
+    logDecryptor->decryptFrame(frame, nullptr);
+}
 
-        DEBUG("Byte position: {}; data length: {};", pCipher - cipher, dataLen);
+/// @brief Sizes batches of encrypted data decrypted into memory by the plaintext they
+///        decrypt to, which compressed entries make larger than the encrypted data.
+///        How much larger is learnt from the batches decrypted before.
+struct DecryptionBatchSizer
+{
+    double expansion = DECRYPTION_EXPANSION_GUESS;
+    bool measured = false;
 
-        if (dataType == logger::DataTypeSymKey)
+    /// @brief Most bytes of encrypted data to decrypt into memory at once,
+    ///        so that about `DECRYPTION_BATCH_MAX_LEN` bytes of plaintext are held.
+    unsigned long long getMaxLen() const
+    {
+        return static_cast<unsigned long long>(DECRYPTION_BATCH_MAX_LEN / this->expansion);
+    }
+
+    /// @brief Learn from a batch of `encryptedLen` bytes that decrypted to `plainLen` bytes.
+    ///        The largest expansion seen is kept, as later files may compress better.
+    void update(unsigned long long encryptedLen, unsigned long long plainLen)
+    {
+        if (encryptedLen == 0)
+            return;
+        double observed = std::max(1.0, static_cast<double>(plainLen) / encryptedLen);
+        this->expansion = this->measured ? std::max(this->expansion, observed) : observed;
+        this->measured = true;
+    }
+};
+
+/// @brief Load the key a resumed decryption continues with.
+static void loadResumedKey(logger::LogDecryptor *logDecryptor,
+                           logger::LogReader *reader,
+                           const logger::DecryptionProgress &progress)
+{
+    if (progress.keyOffset == 0)
+        return;
+    loadKeyFrame(logDecryptor, reader, progress.keyOffset);
+
+    // Segment keys decrypted before are derived again, and
+    // entries decrypted before still count towards the nonce.
+    logger::LogFrame frame;
+    while (reader->getOffset() < progress.offset && reader->next(&frame))
+        logDecryptor->decryptFrame(frame, nullptr);
+}
+
+unsigned long long logger::LogDecryptor::decryptFile(const std::filesystem::path &path,
+                                                    LogSink *sink,
+                                                    unsigned int threads,
+                                                    DecryptionProgress *progress)
+{
+    DecryptionProgress current;
+    if (progress != nullptr)
+        current = *progress;
+
+    // Keys do not carry over from one file to the next.
+    delete this->rotatingSymKey;
+    this->rotatingSymKey = nullptr;
+    delete this->fileKey;
+    this->fileKey = nullptr;
+
+    std::vector<LogSegment> chunks;
+    if (threads > 1)
+    {
+        // Consecutive segments are merged into chunks big enough to be
+        // worth a task. A chunk still starts with a key or segment key frame.
+        // When resuming, segment key frames before the next key frame
+        // are derived from the key the last run stopped at.
+        for (auto &segment : scanSegments(path, current.offset, current.keyOffset))
+            if (!chunks.empty() && chunks.back().end - chunks.back().begin < DECRYPTION_CHUNK_MIN_LEN)
+                chunks.back().end = segment.end;
+            else
+                chunks.push_back(segment);
+        DEBUG("Split log file into {} chunks", chunks.size());
+    }
+
+    if (chunks.size() <= 1)
+    {
+        DEBUG("Begin decryption loop");
+        LogReader reader(path);
+        unsigned long long begin = current.offset == 0 ? reader.getOffset() : current.offset;
+        loadResumedKey(this, &reader, current);
+        auto entries = this->decryptSegment(&reader, {begin, ULLONG_MAX}, sink, &current);
+
+        if (progress != nullptr)
+            *progress = current;
+        return entries;
+    }
+
+    // Chunks starting with a segment key frame each need the file key,
+    // which is then only unwrapped once.
+    crypto::KeyCache localKeyCache;
+    crypto::KeyCache *keyCache = this->keyCache != nullptr ? this->keyCache : &localKeyCache;
+
+    WorkStealingPool pool(threads);
+    std::atomic<unsigned long long> entries{0};
+    DecryptionBatchSizer batchSizer;
+    size_t batchBegin = 0;
+
+    // Only a batch of chunks is held in memory at a time.
+    while (batchBegin < chunks.size())
+    {
+        size_t batchEnd = batchBegin;
+        unsigned long long batchLen = 0;
+        while (batchEnd < chunks.size() && batchLen < batchSizer.getMaxLen() &&
+               batchEnd - batchBegin < threads * DECRYPTION_CHUNKS_PER_THREAD)
         {
-            delete rotatingSymKey;
-            DEBUG("Load sym key");
-            rotatingSymKey = this->newSymKeyFromData(pCipher, dataLen);
+            batchLen += chunks[batchEnd].end - chunks[batchEnd].begin;
+            batchEnd++;
         }
-        else
-        {
-            *pPlain = '\n';
-            pPlain++;
 
-            DEBUG("Decrypt data");
-            size_t outputLen = 0;
-            try
-            {
-                rotatingSymKey->decrypt(pCipher, dataLen, pPlain, dataLen, &outputLen);
-                pPlain += outputLen;
-            }
-            catch (const crypto::DecryptionError &ex)
-            {
-                SPDERROR(ex.what());
-            }
+        std::vector<MemoryLogSink> outputs(batchEnd - batchBegin);
+        std::vector<DecryptionProgress> chunkProgress(batchEnd - batchBegin);
+        std::vector<std::function<void()>> tasks;
+        for (size_t i = batchBegin; i < batchEnd; i++)
+            tasks.push_back([this, &path, &chunks, &outputs, &chunkProgress, &entries, &current, keyCache, i, batchBegin]()
+                            {
+                                // Each chunk unwraps its own key. Only the first one
+                                // may continue with the key of a previous run.
+                                LogDecryptor logDecryptor(this->asymKey, keyCache);
+                                LogReader reader(path);
+                                if (i == 0)
+                                    loadResumedKey(&logDecryptor, &reader, current);
+                                else if (chunks[i].keyOffset != 0 && chunks[i].keyOffset != chunks[i].begin)
+                                    loadKeyFrame(&logDecryptor, &reader, chunks[i].keyOffset);
+                                entries += logDecryptor.decryptSegment(
+                                    &reader, chunks[i], &outputs[i - batchBegin], &chunkProgress[i - batchBegin]);
+                            });
+        pool.run(std::move(tasks));
+
+        unsigned long long plainLen = 0;
+        for (size_t i = 0; i < outputs.size(); i++)
+        {
+            plainLen += outputs[i].getSize();
+            outputs[i].replay(sink);
+            if (chunkProgress[i].frames == 0)
+                continue;
+            current.offset = chunkProgress[i].offset;
+            current.frames += chunkProgress[i].frames;
+            if (chunkProgress[i].keyOffset != 0)
+                current.keyOffset = chunkProgress[i].keyOffset;
         }
-
-        pCipher += dataLen;
+        batchSizer.update(batchLen, plainLen);
+        batchBegin = batchEnd;
     }
 
-    *outputLen = pPlain - plain;
-    delete rotatingSymKey;
+    if (progress != nullptr)
+        *progress = current;
+    return entries;
 }
 
-crypto::SymKey *logger::LogDecryptor::newSymKeyFromData(CryptoPP::byte *data, size_t dataLen)
+crypto::SymKey *logger::LogDecryptor::newSymKeyFromData(const CryptoPP::byte *data, size_t dataLen)
 {
-    CryptoPP::byte outBuffer[dataLen];
+    if (this->keyCache != nullptr)
+        return this->keyCache->unwrap(this->asymKey, data, dataLen);
+
+    std::vector<CryptoPP::byte> outBuffer(dataLen);
     size_t outputLen = 0;
 
-    this->asymKey->decrypt(data, dataLen, outBuffer, dataLen, &outputLen);
-    return new crypto::SymKey(outBuffer, outputLen);
+    this->asymKey->decrypt(data, dataLen, outBuffer.data(), dataLen, &outputLen);
+    return new crypto::SymKey(outBuffer.data(), outputLen);
 }
 
 logger::LogDecryptor::~LogDecryptor()
 {
+    delete this->rotatingSymKey;
+    delete this->fileKey;
 }
 
-void logger::decryptLogFiles(
-    std::filesystem::path sourceDir,
-    std::filesystem::path destinationDir,
-    crypto::AsymKey *asymKey)
+double logger::DecryptionSummary::getThroughput() const
 {
-    using namespace std;
-    LogDecryptor logDecryptor(asymKey);
-    regex baseNamePattern(LOGFILE_BASE_NAME_PATTERN);
+    return this->seconds > 0 ? this->bytes / 1e6 / this->seconds : 0;
+}
+
+/// @brief Decrypt a single log file, recording the outcome in `result`.
+///        It continues from, and updates, `result->manifestEntry`.
+/// @param threads Number of threads decrypting segments of the file.
+/// @param format How the decrypted entries are laid out.
+static void decryptLogFile(logger::LogDecryptor *logDecryptor,
+                           logger::DecryptionResult *result,
+                           unsigned int threads,
+                           logger::LogFileFormat format)
+{
+    auto start = std::chrono::steady_clock::now();
+    auto &entry = result->manifestEntry;
+    INFO("Process log file `{}` with size of {} bytes from byte {}",
+         result->source.u8string(), result->bytes, entry.progress.offset);
+
+    try
+    {
+        // Whatever was written after the recorded output size
+        // (e.g. by an interrupted run) is discarded.
+        logger::FileLogSink sink(result->destination, entry.outputSize, format);
+        auto progress = entry.progress;
+        result->entries = logDecryptor->decryptFile(result->source, &sink, threads, &progress);
+
+        result->decryptedBytes = progress.offset - entry.progress.offset;
+        entry.progress = progress;
+        entry.outputSize = sink.getSize();
+    }
+    catch (const std::exception &ex)
+    {
+        SPDERROR("Cannot decrypt log file `{}`: {}", result->source.u8string(), ex.what());
+        result->error = ex.what();
+    }
+
+    result->seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
 
+/// @brief Encrypted log files of `sourceDir` within the date range of `options`,
+///        sorted by name, so by date.
+static std::vector<std::filesystem::path> listEncryptedLogFiles(
+    const std::filesystem::path &sourceDir,
+    const logger::DecryptionOptions &options)
+{
+    using namespace std;
     vector<filesystem::path> files = getFileListByRegex(
         sourceDir,
         regex(ENC_LOGFILE_REGEX_PATTERN,
               regex_constants::icase));
-    INFO("Found {} log files to decrypt", files.size());
+    sort(files.begin(), files.end());
 
-    for (auto &file : files)
+    // Log files are named after their date, so the names compare like dates.
+    auto outOfRange = [&options](const filesystem::path &file)
     {
-        auto size = filesystem::file_size(file);
-        INFO("Process log file `{}` with size of {} bytes", file.string(), size);
-        unsigned char inBuffer[size];
-        unsigned char outBuffer[size];
-        size_t outputLen = 0;
+        auto date = file.filename().u8string().substr(0, 8);
+        return (!options.fromDate.empty() && date < options.fromDate) ||
+               (!options.toDate.empty() && date > options.toDate);
+    };
+    files.erase(remove_if(files.begin(), files.end(), outOfRange), files.end());
+    INFO("Found {} log files to decrypt", files.size());
+    return files;
+}
+
+logger::DecryptionSummary logger::decryptLogFiles(
+    std::filesystem::path sourceDir,
+    std::filesystem::path destinationDir,
+    crypto::AsymKey *asymKey,
+    const DecryptionOptions &options)
+{
+    using namespace std;
+    auto start = chrono::steady_clock::now();
+    auto keyCache = options.keyCache;
+    crypto::KeyCacheStats keyCacheBefore;
+    if (keyCache != nullptr)
+        keyCacheBefore = keyCache->getStats();
+    regex baseNamePattern(LOGFILE_BASE_NAME_PATTERN);
+    DecryptionManifest manifest(destinationDir);
+    auto files = listEncryptedLogFiles(sourceDir, options);
 
-        DEBUG("Read log file to buffer");
-        ifstream f(file, ios::binary);
-        f.read((char *)&inBuffer[0], size);
+    DecryptionSummary summary;
+    summary.results.resize(files.size());
 
-        DEBUG("Decrypt log file in buffer");
-        logDecryptor.decrypt(&inBuffer[0], size, &outBuffer[0], size, &outputLen);
+    // Files with the same output (e.g. differing only in case) share a task,
+    // so they are appended one after the other.
+    map<filesystem::path, vector<size_t>> resultsByDestination;
+    for (size_t i = 0; i < files.size(); i++)
+    {
+        auto &result = summary.results[i];
+        result.source = files[i];
+        result.bytes = filesystem::file_size(files[i]);
 
-        auto fileName = file.filename().u8string();
+        auto fileName = files[i].filename().u8string();
         smatch baseNameMatch;
         regex_search(fileName, baseNameMatch, baseNamePattern);
-        string outputFileName = string(baseNameMatch[0]) + string(LOGFILE_SUFFIX);
+        string outputFileName = string(baseNameMatch[0]) + getLogFileSuffix(options.format);
+        result.destination = destinationDir / filesystem::path(outputFileName);
+
+        resultsByDestination[result.destination].push_back(i);
+    }
+
+    vector<pair<unsigned long long, vector<size_t>>> jobs;
+    for (auto &[destination, indices] : resultsByDestination)
+    {
+        unsigned long long bytes = 0;
+        for (size_t i : indices)
+        {
+            auto &result = summary.results[i];
+            auto fileName = result.source.filename().u8string();
+            ManifestEntry entry;
+
+            // Shared outputs are always decrypted again as a whole. Otherwise, a
+            // file continues where it stopped, unless it (or its output) shrank,
+            // or it was last decrypted into another format. Manifests from before
+            // the output was recorded only have outputs in the logger's format.
+            auto outputFileName = destination.filename().u8string();
+            if (indices.size() == 1 && manifest.find(fileName, &entry) &&
+                (entry.output == outputFileName ||
+                 (entry.output.empty() && options.format == LogFileFormatLog)) &&
+                entry.progress.offset <= result.bytes && filesystem::exists(destination) &&
+                filesystem::file_size(destination) >= entry.outputSize)
+            {
+                result.manifestEntry = entry;
+                result.resumed = true;
+            }
+            else
+                manifest.remove(fileName);
+
+            result.manifestEntry.output = outputFileName;
+            bytes += result.bytes - result.manifestEntry.progress.offset;
+        }
+
+        if (bytes == 0)
+        {
+            DEBUG("Nothing new to decrypt for `{}`", destination.u8string());
+            continue;
+        }
+        jobs.emplace_back(bytes, indices);
+    }
 
-        ofstream of(destinationDir / filesystem::path(outputFileName), ios::binary | ios::app);
-        of.write((char *)&outBuffer[0], outputLen);
+    // The largest files start first, so a big file
+    // does not leave the other threads idle at the end.
+    sort(jobs.begin(), jobs.end(), [](const auto &a, const auto &b)
+         { return a.first > b.first; });
+
+    WorkStealingPool pool(options.threads);
+    summary.threads = pool.getThreadCount();
+
+    // With fewer files than threads, the spare threads
+    // decrypt segments within the files instead.
+    unsigned int threadsPerFile = jobs.empty() || jobs.size() >= summary.threads
+                                      ? 1
+                                      : summary.threads / jobs.size();
+
+    vector<function<void()>> tasks;
+    for (auto &job : jobs)
+        tasks.push_back([&summary, &options, asymKey, keyCache, threadsPerFile, indices = job.second]()
+                        {
+                            LogDecryptor logDecryptor(asymKey, keyCache);
+                            for (size_t k = 0; k < indices.size(); k++)
+                            {
+                                auto &result = summary.results[indices[k]];
+                                // The next file sharing the output appends to it.
+                                if (k > 0 && filesystem::exists(result.destination))
+                                    result.manifestEntry.outputSize = filesystem::file_size(result.destination);
+                                decryptLogFile(&logDecryptor, &result, threadsPerFile, options.format);
+                                if (options.onFileDecrypted)
+                                    options.onFileDecrypted(result);
+                            }
+                        });
+    pool.run(move(tasks));
+
+    for (size_t i = 0; i < summary.results.size(); i++)
+    {
+        auto &result = summary.results[i];
+        summary.bytes += result.decryptedBytes;
+        if (!result.error.empty())
+            summary.failed++;
+        else if (resultsByDestination[result.destination].size() == 1)
+            manifest.set(result.source.filename().u8string(), result.manifestEntry);
     }
+
+    try
+    {
+        manifest.save();
+    }
+    catch (const std::exception &ex)
+    {
+        SPDERROR("Cannot save decryption manifest: {}", ex.what());
+    }
+    summary.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    INFO("Decrypted {} bytes of {} log files in {:.2f} seconds with {} threads, {:.1f} MB/s, {} failed",
+         summary.bytes, files.size(), summary.seconds, summary.threads,
+         summary.getThroughput(), summary.failed);
+
+    if (keyCache != nullptr)
+    {
+        summary.keyCache = keyCache->getStats().since(keyCacheBefore);
+        INFO("Key cache: {} hits, {} misses ({:.0f}% hit rate), saved about {:.2f} seconds of RSA",
+             summary.keyCache.hits, summary.keyCache.misses,
+             summary.keyCache.getHitRate() * 100, summary.keyCache.getSavedSeconds());
+    }
+    return summary;
+}
+
+logger::DecryptionSummary logger::queryLogFiles(
+    std::filesystem::path sourceDir,
+    crypto::AsymKey *asymKey,
+    LogSink *sink,
+    const DecryptionOptions &options)
+{
+    using namespace std;
+    auto start = chrono::steady_clock::now();
+    crypto::KeyCacheStats keyCacheBefore;
+    if (options.keyCache != nullptr)
+        keyCacheBefore = options.keyCache->getStats();
+
+    auto files = listEncryptedLogFiles(sourceDir, options);
+    DecryptionSummary summary;
+    summary.results.resize(files.size());
+    for (size_t i = 0; i < files.size(); i++)
+    {
+        summary.results[i].source = files[i];
+        summary.results[i].bytes = filesystem::file_size(files[i]);
+    }
+
+    WorkStealingPool pool(options.threads);
+    summary.threads = pool.getThreadCount();
+    LogDecryptor logDecryptor(asymKey, options.keyCache);
+
+    // Decrypts a file into `fileSink`, recording the outcome in `result`.
+    auto decrypt = [](LogDecryptor *logDecryptor, DecryptionResult *result,
+                      LogSink *fileSink, unsigned int threads)
+    {
+        auto fileStart = chrono::steady_clock::now();
+        DecryptionProgress progress;
+        try
+        {
+            result->entries = logDecryptor->decryptFile(result->source, fileSink, threads, &progress);
+        }
+        catch (const std::exception &ex)
+        {
+            SPDERROR("Cannot decrypt log file `{}`: {}", result->source.u8string(), ex.what());
+            result->error = ex.what();
+        }
+        result->decryptedBytes = progress.offset;
+        result->seconds = chrono::duration<double>(chrono::steady_clock::now() - fileStart).count();
+    };
+
+    auto finish = [&](DecryptionResult &result)
+    {
+        summary.bytes += result.decryptedBytes;
+        if (!result.error.empty())
+            summary.failed++;
+        if (options.onFileDecrypted)
+            options.onFileDecrypted(result);
+    };
+
+    // Small files are decrypted in parallel batches into memory, then passed
+    // on in order. A large file is passed on as it is decrypted, its segments
+    // decrypted in parallel instead. Either way, batches are sized by the
+    // plaintext they decrypt to, so about `DECRYPTION_BATCH_MAX_LEN` bytes
+    // of plaintext are held at a time.
+    DecryptionBatchSizer batchSizer;
+    size_t batchBegin = 0;
+    while (batchBegin < files.size())
+    {
+        auto batchMaxLen = batchSizer.getMaxLen();
+        if (summary.results[batchBegin].bytes >= batchMaxLen / summary.threads)
+        {
+            auto &result = summary.results[batchBegin];
+            decrypt(&logDecryptor, &result, sink, summary.threads);
+            finish(result);
+            batchBegin++;
+            continue;
+        }
+
+        size_t batchEnd = batchBegin;
+        unsigned long long batchLen = 0;
+        while (batchEnd < files.size() && batchLen < batchMaxLen &&
+               summary.results[batchEnd].bytes < batchMaxLen / summary.threads &&
+               batchEnd - batchBegin < summary.threads * DECRYPTION_CHUNKS_PER_THREAD)
+        {
+            batchLen += summary.results[batchEnd].bytes;
+            batchEnd++;
+        }
+
+        vector<MemoryLogSink> outputs(batchEnd - batchBegin);
+        vector<function<void()>> tasks;
+        for (size_t i = batchBegin; i < batchEnd; i++)
+            tasks.push_back([&summary, &outputs, &options, &decrypt, asymKey, i, batchBegin]()
+                            {
+                                LogDecryptor fileDecryptor(asymKey, options.keyCache);
+                                decrypt(&fileDecryptor, &summary.results[i], &outputs[i - batchBegin], 1);
+                            });
+        pool.run(move(tasks));
+
+        unsigned long long plainLen = 0;
+        for (size_t i = batchBegin; i < batchEnd; i++)
+        {
+            plainLen += outputs[i - batchBegin].getSize();
+            // A sink failing on one file does not stop the others.
+            try
+            {
+                outputs[i - batchBegin].replay(sink);
+            }
+            catch (const std::exception &ex)
+            {
+                SPDERROR("Cannot query log file `{}`: {}", summary.results[i].source.u8string(), ex.what());
+                summary.results[i].error = ex.what();
+            }
+            finish(summary.results[i]);
+        }
+        batchSizer.update(batchLen, plainLen);
+        batchBegin = batchEnd;
+    }
+
+    summary.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    INFO("Queried {} bytes of {} log files in {:.2f} seconds with {} threads, {:.1f} MB/s, {} failed",
+         summary.bytes, files.size(), summary.seconds, summary.threads,
+         summary.getThroughput(), summary.failed);
+
+    if (options.keyCache != nullptr)
+        summary.keyCache = options.keyCache->getStats().since(keyCacheBefore);
+    return summary;
 }
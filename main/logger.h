@@ -1,24 +1,36 @@
 #ifndef MAIN_LOGGER
 #define MAIN_LOGGER
+#include <chrono>
 #include <filesystem>
 #include <fstream>
+#include <functional>
+#include <string>
 #include <time.h>
+#include <vector>
 
 #include "json.hpp"
 
+#include "capture-arena.h"
+#include "capturer.h"
+#include "compression.h"
 #include "config.h"
 #include "crypto.h"
+#include "decryption-manifest.h"
+#include "key-cache.h"
+#include "frame-buffer.h"
+#include "log-reader.h"
+#include "log-writer.h"
 
-nlohmann::json generateBasicLogEntry(Config config, time_t timestamp);
+/// Names of encrypted log files, case insensitive.
+#define ENC_LOGFILE_REGEX_PATTERN "\\d{8}\\.json\\.log\\.enc"
+
+void generateBasicLogEntry(CaptureSource *captureSource,
+                           time_t timestamp,
+                           LogEntry *entry,
+                           AppRecord *activeApp = nullptr);
 
 namespace logger
 {
-    enum DataType
-    {
-        DataTypeJson = 0,
-        DataTypeSymKey = 1
-    };
-
     class Logger
     {
     private:
@@ -26,74 +38,259 @@ namespace logger
         crypto::AsymKey *asymKey = nullptr;
         /// @brief AES key to encrypt log entries.
         crypto::SymKey *rotatingSymKey = nullptr;
+        /// @brief Last RSA-wrapped AES key, which segment keys are derived from.
+        crypto::SymKey *fileKey = nullptr;
+        /// @brief Number of the segment key in use, `0` for the file key itself.
+        unsigned long long segment = 0;
         Config *config = nullptr;
+        CaptureSource *captureSource = nullptr;
+        /// @brief Holds the snapshot of the current `captureAndAppend`.
+        CaptureArena arena;
+
+        /// @brief The app in focus at the last capture, used to only
+        ///        log focus probes when the focus has changed.
+        AppRecord lastFocus;
+        /// @brief Reused for the app of every focus probe.
+        AppRecord probedFocus;
+        bool lastFocusKnown = false;
+        /// @brief Was the user away at the last capture?
+        bool lastFocusIdle = false;
 
         /// @brief How many logs since the last AES key generation.
         unsigned int logsSinceLatestKeyGen = 0;
-        /// @brief The date (in YYYYMMDD format) of the last append.
-        std::string lastAppendDate;
+        /// @brief Version specifier of the open encrypted log file. Files made
+        ///        by older versions keep being appended to in their own format.
+        char fileVersion = ENC_LOGFILE_VERSION;
+        /// @brief Number of entries encrypted with the current AES key,
+        ///        which the AES-GCM nonce is derived from.
+        unsigned long long nonceCounter = 0;
         /// @brief Path to the log directory.
         std::filesystem::path outDir;
+        /// @brief Keeps the day's log file open between appends.
+        LogWriter *writer = nullptr;
+        /// @brief Reused for every frame written to the log file.
+        FrameBuffer frame;
+        /// @brief Entries waiting to be encrypted together into a batch frame,
+        ///        after the space reserved for the frame header.
+        FrameBuffer batch;
+        /// @brief End offset of every entry in `batch`, from the first entry.
+        std::vector<size_t> batchEnds;
+        /// @brief When the first entry of the batch was added.
+        std::chrono::steady_clock::time_point batchStart;
+        /// @brief Compresses the plain data of every frame,
+        ///        `nullptr` if compression is disabled.
+        Compressor *compressor = nullptr;
 
-        /// @brief Get the appropriate log file name. If encryption is enabled,
-        ///        will create a new encrypted log file for the day (if it doesn't exist)
-        ///        and put a version specifier on the first byte.
+        /// @brief Point the writer at the day's log file. If encryption is enabled,
+        ///        a newly created log file gets a version specifier on the first byte,
+        ///        and a newly opened one gets a new symmetric key.
         /// @param timestamp Unix timestamp
-        /// @return Full log file path
-        std::string prepareLogFile(time_t timestamp);
-        void appendBinary(DataType type, unsigned char *data, size_t dataLen, std::ofstream *fileStream);
+        void prepareLogFile(time_t timestamp);
+        void appendBinary(DataType type, unsigned char *data, size_t dataLen);
+        /// @brief Encrypt the plain data following the frame header of `buffer`
+        ///        with AES-GCM, authenticating the header too, and write the frame.
+        ///        The plain data is compressed first if it is enabled, and helps.
+        void writeAuthenticated(FrameBuffer *buffer, DataType type);
+
+        /// @brief Add an entry to the batch, and write the batch
+        ///        once it is full, or its oldest entry is too old.
+        void appendToBatch(const LogEntry &entry);
+        /// @brief Encrypt the batched entries into a single frame, and write it.
+        void commitBatch();
 
-        /// @brief Append current symmetric key to file stream encrypted with public key.
-        void appendSymKey(std::ofstream *fileStream);
-        void generateAndAppendSymKey(std::string logPath);
-        void generateAndAppendSymKey(std::ofstream *fileStream);
+        /// @brief Append current symmetric key to the log file encrypted with public key.
+        void appendSymKey();
+        void generateAndAppendSymKey();
+        /// @brief Switch to the next key. In AES-GCM files, it is derived from the
+        ///        file key, and only its segment number is appended. Older files
+        ///        get a new RSA-wrapped key.
+        void rotateSymKey();
 
     public:
         Logger(Config *config);
         ~Logger();
 
-        /// @brief Capture and append a json entry to the log file.
+        /// @brief Capture a log snapshot and `write` it to the log file.
+        void captureAndAppend();
+
+        /// @brief Append a captured entry to the log file.
         ///        It also appends the secret AES key
         ///        and rotates it when necessery.
-        void captureAndAppend();
+        /// @param logEntry Captured log entry
+        void write(const LogEntry &logEntry);
 
-        /// @brief Capture a log snapshot.
+        /// @brief Capture a log snapshot of every opened app.
         /// @param timestamp Current time in UNIX
         /// @param durationSinceLastInput Seconds since last user input or interaction
-        /// @return JSON log entry
-        nlohmann::json capture(time_t timestamp, unsigned int durationSinceLastInput = 0);
+        /// @param entry Where the log entry will be put.
+        ///              The apps are allocated with its allocator.
+        void capture(time_t timestamp, unsigned int durationSinceLastInput, LogEntry *entry);
+        void capture(time_t timestamp, LogEntry *entry);
+
+        /// @brief Cheaply capture only the app in focus and the idle state.
+        ///        The compact entry is only produced when either has changed
+        ///        since the last capture.
+        /// @param timestamp Current time in UNIX
+        /// @param entry Where the log entry will be put.
+        /// @return `false` if nothing has changed, and there is nothing to log.
+        bool captureFocus(time_t timestamp, LogEntry *entry);
 
-        /// @brief Append a json entry to the log file.
-        /// @param entry JSON entry
-        /// @param logPath Log path
+        /// @brief Append an entry to the currently open log file.
+        /// @param entry Captured log entry
         /// @param encryptedBinary Should it be encrypted?
-        void append(nlohmann::json entry, std::string logPath, bool encryptedBinary = false);
+        void append(const LogEntry &entry, bool encryptedBinary = false);
+
+        /// @brief Write the batched entries if the oldest
+        ///        has waited `batch.maxAge` seconds.
+        void commitBatchIfDue();
+
+        /// @brief Write the batched entries, and flush buffered entries to the log file.
+        void flush();
+    };
+
+    struct DecryptionResult
+    {
+        std::filesystem::path source;
+        std::filesystem::path destination;
+        /// @brief Size (in bytes) of the encrypted file.
+        unsigned long long bytes = 0;
+        /// @brief Bytes (of the encrypted file) decrypted in this run.
+        unsigned long long decryptedBytes = 0;
+        /// @brief Entries decrypted in this run.
+        unsigned long long entries = 0;
+        /// @brief Was it resumed from where the last run stopped?
+        bool resumed = false;
+        /// @brief Where the decryption starts, and then where it ended.
+        ManifestEntry manifestEntry;
+        double seconds = 0;
+        /// @brief Why the file could not be decrypted, empty on success.
+        std::string error;
+    };
+
+    struct DecryptionSummary
+    {
+        /// @brief One result per file, in the order of the file names.
+        std::vector<DecryptionResult> results;
+        unsigned int threads = 0;
+        /// @brief Bytes (of the encrypted files) decrypted in this run.
+        unsigned long long bytes = 0;
+        unsigned int failed = 0;
+        double seconds = 0;
+        /// @brief Key cache lookups in this run.
+        crypto::KeyCacheStats keyCache;
+
+        /// @brief Decrypted megabytes (of encrypted data) per second.
+        double getThroughput() const;
+    };
+
+    /// @brief Which log files `decryptLogFiles` decrypts, and how.
+    struct DecryptionOptions
+    {
+        /// @brief Number of threads. `0` uses one per hardware thread.
+        unsigned int threads = 0;
+        /// @brief Cache of unwrapped AES keys, `nullptr` to always unwrap them.
+        crypto::KeyCache *keyCache = nullptr;
+        /// @brief Date (`YYYYMMDD`) of the first log file to decrypt, empty for no limit.
+        std::string fromDate = "";
+        /// @brief Date (`YYYYMMDD`) of the last log file to decrypt, empty for no limit.
+        std::string toDate = "";
+        /// @brief How the decrypted entries are laid out.
+        LogFileFormat format = LogFileFormatLog;
+        /// @brief Called after each decrypted file, from the thread that decrypted it.
+        ///        Optional.
+        std::function<void(const DecryptionResult &)> onFileDecrypted;
     };
 
     class LogDecryptor
     {
     private:
         crypto::AsymKey *asymKey = nullptr;
+        /// @brief Unwrapped keys shared between decryptors, optional.
+        crypto::KeyCache *keyCache = nullptr;
+        /// @brief AES key of the frames being decrypted.
+        crypto::SymKey *rotatingSymKey = nullptr;
+        /// @brief Key of the last key frame, which segment keys are derived from.
+        crypto::SymKey *fileKey = nullptr;
+        /// @brief Number of entry frames since the key frame,
+        ///        which AES-GCM nonces are derived from.
+        unsigned long long nonceCounter = 0;
+        /// @brief Reused for every decrypted entry.
+        std::vector<CryptoPP::byte> plain;
+        /// @brief Reused for every decompressed entry.
+        std::string inflated;
+
         /// @brief Create a SymKey from log data.
         /// @param data Encrypted secret
         /// @param dataLen Length (in bytes) of encrypted secret
         /// @return SymKey
-        crypto::SymKey *newSymKeyFromData(CryptoPP::byte *data, size_t dataLen);
+        crypto::SymKey *newSymKeyFromData(const CryptoPP::byte *data, size_t dataLen);
 
     public:
-        LogDecryptor(crypto::AsymKey *asymKey);
+        /// @param asymKey Private key the AES keys are wrapped with
+        /// @param keyCache Cache of unwrapped AES keys, `nullptr` to always unwrap them.
+        LogDecryptor(crypto::AsymKey *asymKey, crypto::KeyCache *keyCache = nullptr);
+        LogDecryptor(const LogDecryptor &) = delete;
+        LogDecryptor &operator=(const LogDecryptor &) = delete;
         ~LogDecryptor();
 
-        void decrypt(CryptoPP::byte *cipher,
-                     size_t cipherLen,
-                     CryptoPP::byte *plain,
-                     size_t plainLen,
-                     size_t *outputLen = nullptr);
+        /// @brief Decrypt a single frame. Key frames replace the current key,
+        ///        entry frames are decrypted with it and passed on to the sink.
+        ///        A key that cannot be unwrapped or derived throws. Entry frames
+        ///        must be passed in file order, as AES-GCM nonces count them.
+        /// @param sink `nullptr` to skip entry frames, only counting them.
+        /// @param entries Where the number of entries passed on to the sink
+        ///                will be put, more than one for batch frames. Optional.
+        /// @return `false` if the entry could not be decrypted, and was skipped.
+        bool decryptFrame(const LogFrame &frame, LogSink *sink, unsigned int *entries = nullptr);
+
+        /// @brief Decrypt the frames of one segment of a log file.
+        /// @param progress Updated with every decrypted frame.
+        /// @return Number of decrypted entries.
+        unsigned long long decryptSegment(LogReader *reader, const LogSegment &segment,
+                                          LogSink *sink, DecryptionProgress *progress);
+
+        /// @brief Decrypt every frame of an encrypted log file, one at a time.
+        ///        Memory use is bounded by the largest frame, not the file.
+        ///        With more than one thread, the file is split at its key frames,
+        ///        and batches of segments are decrypted in parallel, then passed
+        ///        on to the sink in file order.
+        /// @param path Encrypted log file
+        /// @param sink Where the decrypted entries will be put.
+        /// @param threads Number of threads decrypting segments of the file.
+        /// @param progress Where a previous decryption of the file stopped,
+        ///                 updated to where this one stops. `nullptr` to decrypt
+        ///                 the whole file.
+        /// @return Number of decrypted entries.
+        unsigned long long decryptFile(const std::filesystem::path &path, LogSink *sink,
+                                       unsigned int threads = 1,
+                                       DecryptionProgress *progress = nullptr);
     };
 
-    void decryptLogFiles(
+    /// @brief Decrypt every encrypted log file in `sourceDir` into `destinationDir`,
+    ///        spreading the files over a pool of threads, largest first.
+    ///        A file that cannot be decrypted does not stop the others.
+    ///        A manifest in `destinationDir` records how far each file has been
+    ///        decrypted, so running it again only decrypts newly appended frames,
+    ///        and never duplicates entries.
+    DecryptionSummary decryptLogFiles(
         std::filesystem::path sourceDir,
         std::filesystem::path destinationDir,
-        crypto::AsymKey *asymKey);
+        crypto::AsymKey *asymKey,
+        const DecryptionOptions &options = {});
+
+    /// @brief Decrypt every encrypted log file in `sourceDir` in memory, and pass
+    ///        the entries on to `sink` in file order, without writing any plaintext.
+    ///        Files are decrypted in parallel, but `sink` is only ever called from
+    ///        the calling thread. A file that cannot be decrypted does not stop
+    ///        the others, though the entries before the error are passed on.
+    ///        There is no manifest, every file is decrypted as a whole.
+    /// @param options `format` is unused, the sink decides what to do with entries.
+    ///                `onFileDecrypted` is called from the calling thread,
+    ///                after the entries of the file are passed on.
+    DecryptionSummary queryLogFiles(
+        std::filesystem::path sourceDir,
+        crypto::AsymKey *asymKey,
+        LogSink *sink,
+        const DecryptionOptions &options = {});
 }
 #endif /* MAIN_LOGGER */
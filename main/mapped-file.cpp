@@ -0,0 +1,126 @@
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "dev-logger.h"
+#include "mapped-file.h"
+
+#ifdef _WIN32
+bool MappedFile::open(const std::filesystem::path &path)
+{
+    this->close();
+
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE,
+                              NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0 ||
+        static_cast<unsigned long long>(size.QuadPart) > SIZE_MAX)
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mapping == NULL)
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    void *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (view == NULL)
+    {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    this->fileHandle = file;
+    this->mappingHandle = mapping;
+    this->data = static_cast<const unsigned char *>(view);
+    this->size = static_cast<size_t>(size.QuadPart);
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (this->data != nullptr)
+        UnmapViewOfFile(this->data);
+    if (this->mappingHandle != nullptr)
+        CloseHandle(this->mappingHandle);
+    if (this->fileHandle != nullptr)
+        CloseHandle(this->fileHandle);
+
+    this->data = nullptr;
+    this->size = 0;
+    this->mappingHandle = nullptr;
+    this->fileHandle = nullptr;
+}
+#else
+bool MappedFile::open(const std::filesystem::path &path)
+{
+    this->close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat status;
+    if (fstat(fd, &status) != 0 || status.st_size == 0 ||
+        static_cast<unsigned long long>(status.st_size) > SIZE_MAX)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    size_t size = static_cast<size_t>(status.st_size);
+    void *view = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping keeps its own reference to the file.
+    ::close(fd);
+    if (view == MAP_FAILED)
+        return false;
+
+    if (madvise(view, size, MADV_SEQUENTIAL) != 0)
+        DEBUG("Cannot advise sequential access on `{}`", path.u8string());
+
+    this->data = static_cast<const unsigned char *>(view);
+    this->size = size;
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (this->data != nullptr)
+        munmap(const_cast<unsigned char *>(this->data), this->size);
+
+    this->data = nullptr;
+    this->size = 0;
+}
+#endif
+
+MappedFile::~MappedFile()
+{
+    this->close();
+}
+
+const unsigned char *MappedFile::getData()
+{
+    return this->data;
+}
+
+size_t MappedFile::getSize()
+{
+    return this->size;
+}
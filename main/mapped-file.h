@@ -0,0 +1,34 @@
+#ifndef MAIN_MAPPED_FILE
+#define MAIN_MAPPED_FILE
+#include <cstddef>
+#include <filesystem>
+
+/// @brief Read-only memory mapping of a whole file,
+///        advised for sequential access.
+class MappedFile
+{
+private:
+    const unsigned char *data = nullptr;
+    size_t size = 0;
+#ifdef _WIN32
+    void *fileHandle = nullptr;
+    void *mappingHandle = nullptr;
+#endif
+
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+    ~MappedFile();
+
+    /// @brief Map the file.
+    /// @return `false` if the file cannot be mapped (e.g. it is empty,
+    ///         or the address space is too small), so it should be read instead.
+    bool open(const std::filesystem::path &path);
+    void close();
+
+    const unsigned char *getData();
+    size_t getSize();
+};
+
+#endif /* MAIN_MAPPED_FILE */
@@ -0,0 +1,373 @@
+#include <cstdio>
+#include <exception>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <regex>
+#include <string>
+#include <vector>
+
+#include "dev-logger.h"
+
+#include "cli.h"
+#include "config.h"
+#include "crypto.h"
+#include "helpers.h"
+#include "key-cache.h"
+#include "log-query.h"
+#include "logger.h"
+
+/// Default longest gap (in seconds) between two entries that counts towards app usage.
+#define USAGE_MAX_GAP 300
+
+using namespace std;
+using cli::UsageError;
+
+static const char *USAGE =
+    "Usage: owl-decrypt [options] <source-dir>...\n"
+    "\n"
+    "Decrypt the encrypted log files of one or more directories, without prompting.\n"
+    "Running it again only decrypts what was appended since the last run.\n"
+    "With `--stdout`, `--match` or `--usage`, the logs are decrypted in memory\n"
+    "instead, and no plaintext is written to disk.\n"
+    "\n"
+    "Options:\n"
+    "  -o, --output <dir>       Where the decrypted log files are put (default `./decrypted-logs`).\n"
+    "                           With several source directories, each one gets\n"
+    "                           a subdirectory named after it.\n"
+    "  -c, --config <file>      Config file to take the key paths and decryption settings from\n"
+    "                           (default: the config next to the executable).\n"
+    "      --private-key <file> Encrypted RSA private key.\n"
+    "      --salt <file>        Salt of the private key password.\n"
+    "      --password-stdin     Read the password from the first line of stdin (default).\n"
+    "      --password-fd <n>    Read the password from the first line of file descriptor n.\n"
+    "      --password-file <f>  Read the password from the first line of a file.\n"
+    "      --from <YYYYMMDD>    Skip log files before this date.\n"
+    "      --to <YYYYMMDD>      Skip log files after this date.\n"
+    "  -j, --threads <n>        Number of decryption threads, 0 for one per hardware thread.\n"
+    "  -f, --format <format>    `log` (as the logger writes them) or `jsonl` (JSON Lines).\n"
+    "      --key-cache <file>   Keep unwrapped AES keys between runs, encrypted with the password.\n"
+    "      --stdout             Write the entries to stdout as JSON Lines, instead of to files.\n"
+    "      --match <regex>      Only write entries with an app whose path or title matches\n"
+    "                           (case insensitive). Implies `--stdout`.\n"
+    "      --usage              Print how long each app was active, instead of the entries.\n"
+    "      --max-gap <seconds>  Longest gap between two entries that counts towards usage\n"
+    "                           (default 300).\n"
+    "  -p, --progress           Print a line to stderr for every decrypted file.\n"
+    "  -v, --verbose            Log what is being done to stderr.\n"
+    "  -h, --help               Show this message.\n"
+    "\n"
+    "Exit status is 0 when every file was decrypted, 1 when some could not be,\n"
+    "and 2 when nothing could be decrypted.\n";
+
+struct Arguments
+{
+    vector<string> sourceDirs;
+    string outputDir = "./decrypted-logs";
+    string configPath = "";
+    string privateKeyPath = "";
+    string saltPath = "";
+    /// @brief File descriptor to read the password from, `-1` to read `passwordPath`.
+    int passwordFd = 0;
+    string passwordPath = "";
+    string fromDate = "";
+    string toDate = "";
+    /// @brief Number of threads, `-1` to use the config.
+    long threads = -1;
+    string format = "log";
+    string keyCachePath = "";
+    bool toStdout = false;
+    string match = "";
+    bool usage = false;
+    long maxGap = USAGE_MAX_GAP;
+    bool progress = false;
+    bool verbose = false;
+};
+
+static string parseDate(const string &option, const string &value)
+{
+    if (!regex_match(value, regex("\\d{8}")))
+        throw UsageError("`" + option + "` expects a date as YYYYMMDD, got `" + value + "`");
+    return value;
+}
+
+static Arguments parseArguments(int argc, char **argv)
+{
+    Arguments args;
+    for (int i = 1; i < argc; i++)
+    {
+        string arg = argv[i];
+        auto value = [&]() -> string
+        {
+            if (i + 1 >= argc)
+                throw UsageError("`" + arg + "` expects a value");
+            return argv[++i];
+        };
+
+        if (arg == "-h" || arg == "--help")
+        {
+            fputs(USAGE, stdout);
+            exit(EXIT_DONE);
+        }
+        else if (arg == "-o" || arg == "--output")
+            args.outputDir = value();
+        else if (arg == "-c" || arg == "--config")
+            args.configPath = value();
+        else if (arg == "--private-key")
+            args.privateKeyPath = value();
+        else if (arg == "--salt")
+            args.saltPath = value();
+        else if (arg == "--password-stdin")
+            args.passwordFd = 0;
+        else if (arg == "--password-fd")
+            args.passwordFd = cli::parseNumber(arg, value());
+        else if (arg == "--password-file")
+        {
+            args.passwordFd = -1;
+            args.passwordPath = value();
+        }
+        else if (arg == "--from")
+            args.fromDate = parseDate(arg, value());
+        else if (arg == "--to")
+            args.toDate = parseDate(arg, value());
+        else if (arg == "-j" || arg == "--threads")
+            args.threads = cli::parseNumber(arg, value());
+        else if (arg == "-f" || arg == "--format")
+            args.format = value();
+        else if (arg == "--key-cache")
+            args.keyCachePath = value();
+        else if (arg == "--stdout")
+            args.toStdout = true;
+        else if (arg == "--match")
+        {
+            args.match = value();
+            args.toStdout = true;
+        }
+        else if (arg == "--usage")
+            args.usage = true;
+        else if (arg == "--max-gap")
+            args.maxGap = cli::parseNumber(arg, value());
+        else if (arg == "-p" || arg == "--progress")
+            args.progress = true;
+        else if (arg == "-v" || arg == "--verbose")
+            args.verbose = true;
+        else if (arg.size() > 1 && arg[0] == '-')
+            throw UsageError("Unknown option `" + arg + "`");
+        else
+            args.sourceDirs.push_back(arg);
+    }
+
+    if (args.sourceDirs.empty())
+        throw UsageError("No source directory given");
+    if (!args.fromDate.empty() && !args.toDate.empty() && args.fromDate > args.toDate)
+        throw UsageError("`--from` is after `--to`");
+    if (args.usage && args.toStdout)
+        throw UsageError("`--usage` cannot be combined with `--stdout` or `--match`");
+    try
+    {
+        regex(args.match);
+    }
+    catch (const regex_error &ex)
+    {
+        throw UsageError("`--match` is not a valid regular expression: " + string(ex.what()));
+    }
+    return args;
+}
+
+/// @brief Where the decrypted logs of a source directory go.
+static filesystem::path getDestinationDir(const Arguments &args, const filesystem::path &sourceDir)
+{
+    filesystem::path outputDir = filesystem::absolute(args.outputDir);
+    if (args.sourceDirs.size() == 1)
+        return outputDir;
+
+    auto name = sourceDir.filename();
+    if (name.empty())
+        name = sourceDir.parent_path().filename();
+    return outputDir / name;
+}
+
+/// @brief Print how long each app was active in the logs of `sourceDir`,
+///        decrypting them in memory.
+static logger::DecryptionSummary printUsage(const Arguments &args,
+                                            const filesystem::path &sourceDir,
+                                            crypto::AsymKey *asymKey,
+                                            const logger::DecryptionOptions &options)
+{
+    INFO("Add up app usage of log files from `{}`", sourceDir.u8string());
+    logger::AppUsageAggregator aggregator(args.maxGap);
+    auto summary = logger::queryLogFiles(sourceDir, asymKey, &aggregator, options);
+    if (aggregator.getDiscarded() > 0)
+        fprintf(stderr, "%s: skipped %llu entries that are not valid JSON\n",
+                sourceDir.u8string().c_str(), aggregator.getDiscarded());
+
+    printf("# %s\n", sourceDir.u8string().c_str());
+    for (auto const &usage : aggregator.getUsage())
+        printf("%llu\t%llu\t%s\n", usage.seconds, usage.entries, usage.path.c_str());
+    fflush(stdout);
+    return summary;
+}
+
+static int run(const Arguments &args)
+{
+    Config config = args.configPath.empty() ? loadConfig()
+                                            : cli::loadConfigFile(args.configPath);
+
+    auto privateKeyPath = args.privateKeyPath.empty()
+                              ? prepareAndProcessPath(config.encryption.rsaPrivateKeyPath, false)
+                              : filesystem::absolute(args.privateKeyPath);
+    auto saltPath = args.saltPath.empty()
+                        ? prepareAndProcessPath(config.encryption.saltPath, false)
+                        : filesystem::absolute(args.saltPath);
+    string keyCachePath = !args.keyCachePath.empty()
+                              ? filesystem::absolute(args.keyCachePath).u8string()
+                          : config.decryption.keyCachePath.empty()
+                              ? ""
+                              : prepareAndProcessPath(config.decryption.keyCachePath).u8string();
+
+    logger::DecryptionOptions options;
+    options.threads = args.threads < 0 ? config.decryption.threads : args.threads;
+    options.fromDate = args.fromDate;
+    options.toDate = args.toDate;
+    options.format = logger::parseLogFileFormat(args.format);
+
+    // Reading the password is the last thing that may wait on the caller,
+    // so a bad argument is reported before it is asked for.
+    string password = cli::readPassword(args.passwordFd, args.passwordPath);
+
+    unique_ptr<crypto::SymKeyPasswordBased> symKey;
+    crypto::AsymKey asymKey;
+    try
+    {
+        symKey.reset(cli::loadPrivateKey(password, privateKeyPath, saltPath, &asymKey));
+    }
+    catch (const crypto::DecryptionError &ex)
+    {
+        SPDERROR(ex.what());
+        fputs("Cannot decrypt the RSA private key, the password may be incorrect.\n", stderr);
+        return EXIT_UNUSABLE;
+    }
+
+    crypto::KeyCache keyCache;
+    if (!keyCachePath.empty() && filesystem::exists(keyCachePath))
+    {
+        try
+        {
+            keyCache.loadFromFile(keyCachePath, symKey.get());
+        }
+        catch (const std::exception &ex)
+        {
+            WARN("Cannot load key cache from `{}`: {}", keyCachePath, ex.what());
+        }
+    }
+    options.keyCache = &keyCache;
+
+    // Progress lines come from the decrypting threads.
+    mutex progressMutex;
+    unsigned long long filesDone = 0;
+    if (args.progress)
+        options.onFileDecrypted = [&](const logger::DecryptionResult &result)
+        {
+            lock_guard<mutex> lock(progressMutex);
+            filesDone++;
+            if (result.error.empty())
+                fprintf(stderr, "[%llu] %s: %llu entries, %llu bytes in %.2f s\n",
+                        filesDone, result.source.u8string().c_str(),
+                        result.entries, result.decryptedBytes, result.seconds);
+            else
+                fprintf(stderr, "[%llu] %s: failed, %s\n",
+                        filesDone, result.source.u8string().c_str(), result.error.c_str());
+        };
+
+    unsigned int failed = 0;
+    size_t decrypted = 0;
+    bool unusableSource = false;
+    for (auto &sourceArg : args.sourceDirs)
+    {
+        auto sourceDir = filesystem::absolute(sourceArg);
+        try
+        {
+            logger::DecryptionSummary summary;
+            if (args.usage)
+                summary = printUsage(args, sourceDir, &asymKey, options);
+            else if (args.toStdout)
+            {
+                INFO("Query log files from `{}`", sourceDir.u8string());
+                logger::StreamLogSink out(stdout);
+                logger::LogEntryFilter filter(&out, 0, 0, args.match);
+                summary = logger::queryLogFiles(sourceDir, &asymKey, &filter, options);
+                fflush(stdout);
+                if (filter.getDiscarded() > 0)
+                    fprintf(stderr, "%s: skipped %llu entries that are not valid JSON\n",
+                            sourceDir.u8string().c_str(), filter.getDiscarded());
+            }
+            else
+            {
+                auto destDir = getDestinationDir(args, sourceDir);
+                filesystem::create_directories(destDir);
+                INFO("Decrypt log files from `{}` to `{}`", sourceDir.u8string(), destDir.u8string());
+                summary = logger::decryptLogFiles(sourceDir, destDir, &asymKey, options);
+            }
+            failed += summary.failed;
+            decrypted += summary.results.size() - summary.failed;
+
+            if (args.progress)
+                fprintf(stderr, "%s: %zu files, %llu bytes in %.2f s with %u threads, %.1f MB/s, %u failed\n",
+                        sourceDir.u8string().c_str(), summary.results.size(), summary.bytes,
+                        summary.seconds, summary.threads, summary.getThroughput(), summary.failed);
+        }
+        catch (const std::exception &ex)
+        {
+            // One unreadable directory does not stop the others.
+            SPDERROR("Cannot decrypt log files from `{}`: {}", sourceDir.u8string(), ex.what());
+            fprintf(stderr, "Cannot decrypt log files from `%s`: %s\n",
+                    sourceDir.u8string().c_str(), ex.what());
+            unusableSource = true;
+        }
+    }
+
+    if (!keyCachePath.empty())
+    {
+        try
+        {
+            keyCache.saveToFile(keyCachePath, symKey.get());
+        }
+        catch (const std::exception &ex)
+        {
+            SPDERROR("Cannot save key cache to `{}`: {}", keyCachePath, ex.what());
+        }
+    }
+
+    if (failed == 0 && !unusableSource)
+        return EXIT_DONE;
+    // Every file that was attempted failed, or no source could be read at all.
+    return decrypted == 0 ? EXIT_UNUSABLE : EXIT_PARTIALLY_DONE;
+}
+
+int main(int argc, char **argv)
+{
+    Arguments args;
+    try
+    {
+        args = parseArguments(argc, argv);
+    }
+    catch (const UsageError &ex)
+    {
+        fprintf(stderr, "owl-decrypt: %s\n\n%s", ex.what(), USAGE);
+        return EXIT_UNUSABLE;
+    }
+
+    // Decrypted entries may be written to stdout by a caller's pipeline,
+    // so everything the tool has to say goes to stderr.
+    cli::initDevLogger("owl-decrypt", args.verbose);
+    try
+    {
+        return run(args);
+    }
+    catch (const std::exception &ex)
+    {
+        SPDERROR(ex.what());
+        fprintf(stderr, "owl-decrypt: %s\n", ex.what());
+        return EXIT_UNUSABLE;
+    }
+}
@@ -0,0 +1,272 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <exception>
+#include <filesystem>
+#include <memory>
+#include <regex>
+#include <string>
+#include <vector>
+
+#include "dev-logger.h"
+
+#include "cli.h"
+#include "config.h"
+#include "crypto.h"
+#include "helpers.h"
+#include "key-cache.h"
+#include "log-verifier.h"
+#include "logger.h"
+
+using namespace std;
+using cli::UsageError;
+
+static const char *USAGE =
+    "Usage: owl-fsck [options] <file-or-dir>...\n"
+    "\n"
+    "Check encrypted log files by walking their frames, without decrypting them.\n"
+    "Directories are searched recursively for encrypted log files.\n"
+    "\n"
+    "Options:\n"
+    "      --decrypt            Also check that every entry decrypts to JSON.\n"
+    "                           Needs the private key password, read like `owl-decrypt` does.\n"
+    "  -c, --config <file>      Config file to take the key paths from.\n"
+    "      --private-key <file> Encrypted RSA private key.\n"
+    "      --salt <file>        Salt of the private key password.\n"
+    "      --password-stdin     Read the password from the first line of stdin (default).\n"
+    "      --password-fd <n>    Read the password from the first line of file descriptor n.\n"
+    "      --password-file <f>  Read the password from the first line of a file.\n"
+    "      --repair             Truncate torn or corrupt files to their last complete frame.\n"
+    "                           Whatever follows it is lost.\n"
+    "      --force              Repair even when perpetual owl is running.\n"
+    "  -j, --threads <n>        Number of threads, 0 for one per hardware thread.\n"
+    "  -a, --all                Print every file, not only those with problems.\n"
+    "  -v, --verbose            Log what is being done to stderr.\n"
+    "  -h, --help               Show this message.\n"
+    "\n"
+    "Exit status is 0 when every file is intact, 1 when some are not\n"
+    "(even if they were repaired), and 2 when nothing could be checked\n"
+    "(no log file was found, or none could be read).\n";
+
+struct Arguments
+{
+    vector<string> paths;
+    bool decrypt = false;
+    string configPath = "";
+    string privateKeyPath = "";
+    string saltPath = "";
+    /// @brief File descriptor to read the password from, `-1` to read `passwordPath`.
+    int passwordFd = 0;
+    string passwordPath = "";
+    bool repair = false;
+    bool force = false;
+    long threads = 0;
+    bool all = false;
+    bool verbose = false;
+};
+
+static Arguments parseArguments(int argc, char **argv)
+{
+    Arguments args;
+    for (int i = 1; i < argc; i++)
+    {
+        string arg = argv[i];
+        auto value = [&]() -> string
+        {
+            if (i + 1 >= argc)
+                throw UsageError("`" + arg + "` expects a value");
+            return argv[++i];
+        };
+
+        if (arg == "-h" || arg == "--help")
+        {
+            fputs(USAGE, stdout);
+            exit(EXIT_DONE);
+        }
+        else if (arg == "--decrypt")
+            args.decrypt = true;
+        else if (arg == "-c" || arg == "--config")
+            args.configPath = value();
+        else if (arg == "--private-key")
+            args.privateKeyPath = value();
+        else if (arg == "--salt")
+            args.saltPath = value();
+        else if (arg == "--password-stdin")
+            args.passwordFd = 0;
+        else if (arg == "--password-fd")
+            args.passwordFd = cli::parseNumber(arg, value());
+        else if (arg == "--password-file")
+        {
+            args.passwordFd = -1;
+            args.passwordPath = value();
+        }
+        else if (arg == "--repair")
+            args.repair = true;
+        else if (arg == "--force")
+            args.force = true;
+        else if (arg == "-j" || arg == "--threads")
+            args.threads = cli::parseNumber(arg, value());
+        else if (arg == "-a" || arg == "--all")
+            args.all = true;
+        else if (arg == "-v" || arg == "--verbose")
+            args.verbose = true;
+        else if (arg.size() > 1 && arg[0] == '-')
+            throw UsageError("Unknown option `" + arg + "`");
+        else
+            args.paths.push_back(arg);
+    }
+
+    if (args.paths.empty())
+        throw UsageError("No file or directory given");
+    return args;
+}
+
+/// @brief Files to check: the given files, and the encrypted
+///        log files found in the given directories.
+static vector<filesystem::path> collectFiles(const vector<string> &paths)
+{
+    regex pattern(ENC_LOGFILE_REGEX_PATTERN, regex_constants::icase);
+    vector<filesystem::path> files;
+    for (auto &path : paths)
+    {
+        if (!filesystem::is_directory(path))
+        {
+            files.push_back(path);
+            continue;
+        }
+
+        for (auto &entry : filesystem::recursive_directory_iterator(path))
+            if (entry.is_regular_file() &&
+                regex_match(entry.path().filename().string(), pattern))
+                files.push_back(entry.path());
+    }
+    sort(files.begin(), files.end());
+    return files;
+}
+
+static void printResult(const logger::VerificationResult &result)
+{
+    string problems;
+    auto add = [&problems](unsigned long long count, const char *what)
+    {
+        if (count != 0)
+            problems += ", " + to_string(count) + " " + what;
+    };
+    add(result.malformedFrames, "malformed frames");
+    add(result.orphanFrames, "entries without a key");
+    add(result.undecryptableKeys, "keys that cannot be unwrapped or derived");
+    add(result.undecryptableFrames, "entries that cannot be decrypted");
+    add(result.invalidEntries, "entries that are not JSON");
+    if (!result.error.empty())
+        problems += ", " + result.error;
+    if (result.repaired)
+        problems += ", truncated to " + to_string(result.validEnd) + " bytes";
+
+    printf("%s: %s, %llu keys, %llu segment keys, %llu entry frames%s\n",
+           result.path.u8string().c_str(), logger::getVerificationStatusName(result.status),
+           result.keyFrames, result.segmentKeyFrames, result.entryFrames, problems.c_str());
+}
+
+static int run(const Arguments &args)
+{
+    if (args.repair && !args.force && isPerpetualInstanceRunning())
+    {
+        // It may be appending to the very file being truncated.
+        fputs("Perpetual owl is running, stop it before repairing, or use `--force`.\n", stderr);
+        return EXIT_UNUSABLE;
+    }
+
+    logger::VerificationOptions options;
+    options.repair = args.repair;
+    options.threads = args.threads;
+
+    unique_ptr<crypto::SymKeyPasswordBased> symKey;
+    crypto::AsymKey asymKey;
+    crypto::KeyCache keyCache;
+    if (args.decrypt)
+    {
+        Config config = args.configPath.empty() ? loadConfig()
+                                                : cli::loadConfigFile(args.configPath);
+        auto privateKeyPath = args.privateKeyPath.empty()
+                                  ? prepareAndProcessPath(config.encryption.rsaPrivateKeyPath, false)
+                                  : filesystem::absolute(args.privateKeyPath);
+        auto saltPath = args.saltPath.empty()
+                            ? prepareAndProcessPath(config.encryption.saltPath, false)
+                            : filesystem::absolute(args.saltPath);
+
+        string password = cli::readPassword(args.passwordFd, args.passwordPath);
+        try
+        {
+            symKey.reset(cli::loadPrivateKey(password, privateKeyPath, saltPath, &asymKey));
+        }
+        catch (const crypto::DecryptionError &ex)
+        {
+            SPDERROR(ex.what());
+            fputs("Cannot decrypt the RSA private key, the password may be incorrect.\n", stderr);
+            return EXIT_UNUSABLE;
+        }
+        options.asymKey = &asymKey;
+        options.keyCache = &keyCache;
+    }
+
+    auto files = collectFiles(args.paths);
+    auto start = chrono::steady_clock::now();
+    auto results = logger::verifyLogFiles(files, options);
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    unsigned long long bytes = 0;
+    unsigned int counts[logger::VerificationUnreadable + 1] = {};
+    unsigned int damaged = 0;
+    unsigned int repaired = 0;
+    for (auto &result : results)
+    {
+        bytes += result.bytes;
+        counts[result.status]++;
+        if (!result.isIntact())
+            damaged++;
+        if (result.repaired)
+            repaired++;
+        if (args.all || !result.isIntact())
+            printResult(result);
+    }
+
+    printf("%zu files, %llu bytes in %.2f s (%.1f MB/s): %u intact, %u torn, %u corrupt, "
+           "%u unreadable, %u with bad frames, %u repaired\n",
+           results.size(), bytes, seconds, seconds > 0 ? bytes / 1e6 / seconds : 0,
+           static_cast<unsigned int>(results.size()) - damaged, counts[logger::VerificationTornTail],
+           counts[logger::VerificationCorrupt], counts[logger::VerificationUnreadable],
+           damaged - counts[logger::VerificationTornTail] - counts[logger::VerificationCorrupt] -
+               counts[logger::VerificationUnreadable],
+           repaired);
+
+    // No file to check, or none that could be read, checked nothing.
+    if (results.empty() || counts[logger::VerificationUnreadable] == results.size())
+        return EXIT_UNUSABLE;
+    return damaged == 0 ? EXIT_DONE : EXIT_PARTIALLY_DONE;
+}
+
+int main(int argc, char **argv)
+{
+    Arguments args;
+    try
+    {
+        args = parseArguments(argc, argv);
+    }
+    catch (const UsageError &ex)
+    {
+        fprintf(stderr, "owl-fsck: %s\n\n%s", ex.what(), USAGE);
+        return EXIT_UNUSABLE;
+    }
+
+    cli::initDevLogger("owl-fsck", args.verbose);
+    try
+    {
+        return run(args);
+    }
+    catch (const std::exception &ex)
+    {
+        SPDERROR(ex.what());
+        fprintf(stderr, "owl-fsck: %s\n", ex.what());
+        return EXIT_UNUSABLE;
+    }
+}
@@ -1,25 +1,122 @@
-#include <Windows.h>
+#include <atomic>
+#include <csignal>
 #include <filesystem>
 
+#ifdef _WIN32
+#include <Windows.h>
+#endif
+
+#include "dev-logger.h"
+#include "spdlog/sinks/rotating_file_sink.h"
+#include "spdlog/spdlog.h"
+
 #include "config.h"
+#include "constants.hpp"
 #include "helpers.h"
-#include "logger.h"
+#include "log-pipeline.h"
+#include "scheduler.h"
 
 using namespace std;
 
-int WinMain(
-    HINSTANCE hInstance,
-    HINSTANCE hPrevInstance,
-    LPSTR lpCmdLine,
-    int nShowCmd)
+void initDevLogger()
+{
+    try
+    {
+        auto maxSize = 1048576; // 1 megabit
+        auto maxFiles = 2;
+        auto outputPath = filesystem::weakly_canonical(
+                              constants::LOG_OUTPUT_DIR /
+                              filesystem::path("./" PERPETUAL_TARGET_NAME ".log"))
+                              .u8string();
+        auto logger = spdlog::rotating_logger_mt(
+            "perpetual", outputPath, maxSize, maxFiles);
+        spdlog::set_default_logger(logger);
+        logger->set_level(DEBUG_BUILD ? spdlog::level::debug : spdlog::level::info);
+        logger->set_pattern("[%Y-%m-%d %T] [%l] %v");
+        spdlog::flush_every(std::chrono::seconds(3));
+    }
+    catch (const spdlog::spdlog_ex &ex)
+    {
+        // Perpetual owl has no console to report to, keep logging without it.
+    }
+}
+
+/// @brief Set on SIGINT or SIGTERM, so the entries still queued
+///        or batched are written before perpetual owl exits.
+static std::atomic<bool> stopRequested{false};
+
+static void requestStop(int signal)
+{
+    stopRequested = true;
+    // A second signal ends it right away, e.g. if writing is stuck.
+    std::signal(signal, SIG_DFL);
+}
+
+/// @brief Run full captures and focus probes until a stop is requested.
+static void captureWithFocusProbes(logger::LogPipeline *pipeline, Scheduler *scheduler,
+                                   double focusProbeInterval)
+{
+    // Full captures take precedence, probes that fall due
+    // at the same time are covered by the full capture.
+    Scheduler probeScheduler(focusProbeInterval, MissedTickSkip);
+    while (!stopRequested.load())
+    {
+        if (scheduler->nextDeadline() <= probeScheduler.nextDeadline())
+        {
+            if (!scheduler->wait(stopRequested))
+                return;
+            pipeline->capture();
+
+            auto now = Scheduler::Clock::now();
+            if (probeScheduler.nextDeadline() <= now)
+                probeScheduler.advance(now);
+            continue;
+        }
+
+        if (!probeScheduler.wait(stopRequested))
+            return;
+        pipeline->captureFocus();
+    }
+}
+
+int runPerpetual()
 {
     killOtherPerpetualInstances();
+    initDevLogger();
     auto config = loadConfig();
 
-    auto lg = logger::Logger(&config);
-    while (true)
+    auto missedTickPolicy = parseMissedTickPolicy(config.missedTicks);
+    logger::LogPipeline pipeline(&config);
+    Scheduler scheduler(config.loggingInterval, missedTickPolicy);
+
+    std::signal(SIGINT, requestStop);
+    std::signal(SIGTERM, requestStop);
+
+    if (config.focusProbeInterval <= 0)
     {
-        lg.captureAndAppend();
-        sleepFor(config.loggingInterval);
+        while (scheduler.wait(stopRequested))
+            pipeline.capture();
     }
+    else
+        captureWithFocusProbes(&pipeline, &scheduler, config.focusProbeInterval);
+
+    INFO("Stop requested, write the remaining log entries");
+    pipeline.stop();
+    return 0;
+}
+
+#ifdef _WIN32
+int WinMain(
+    HINSTANCE hInstance,
+    HINSTANCE hPrevInstance,
+    LPSTR lpCmdLine,
+    int nShowCmd)
+{
+    return runPerpetual();
+}
+#else
+int main()
+{
+    return runPerpetual();
 }
+#endif
@@ -0,0 +1,75 @@
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include "dev-logger.h"
+#include "process-cache.h"
+
+void ProcessCache::beginCapture()
+{
+    this->capture++;
+    this->capturing = true;
+}
+
+void ProcessCache::endCapture()
+{
+    this->capturing = false;
+    for (auto it = this->processes.begin(); it != this->processes.end();)
+    {
+        if (it->second.lastSeen == this->capture)
+        {
+            it++;
+            continue;
+        }
+        it = this->processes.erase(it);
+        this->stats.evictions++;
+    }
+
+    DEBUG("Process cache: {} processes, {} hits, {} misses, {} evictions",
+          this->processes.size(), this->stats.hits,
+          this->stats.misses, this->stats.evictions);
+}
+
+const std::string *ProcessCache::findSeen(unsigned long pid)
+{
+    if (!this->capturing)
+        return nullptr;
+
+    auto it = this->processes.find(pid);
+    if (it == this->processes.end() || it->second.lastSeen != this->capture)
+        return nullptr;
+
+    this->stats.hits++;
+    return &it->second.path;
+}
+
+const std::string *ProcessCache::find(unsigned long pid, unsigned long long startTime)
+{
+    auto it = this->processes.find(pid);
+    if (it == this->processes.end() || it->second.startTime != startTime)
+    {
+        this->stats.misses++;
+        return nullptr;
+    }
+
+    this->stats.hits++;
+    it->second.lastSeen = this->capture;
+    return &it->second.path;
+}
+
+const std::string &ProcessCache::insert(unsigned long pid,
+                                        unsigned long long startTime,
+                                        std::string path)
+{
+    auto &process = this->processes[pid];
+    process.startTime = startTime;
+    process.path = std::move(path);
+    process.lastSeen = this->capture;
+    return process.path;
+}
+
+ProcessCacheStats ProcessCache::getStats()
+{
+    this->stats.size = this->processes.size();
+    return this->stats;
+}
@@ -0,0 +1,60 @@
+#ifndef MAIN_PROCESS_CACHE
+#define MAIN_PROCESS_CACHE
+#include <string>
+#include <unordered_map>
+
+struct ProcessCacheStats
+{
+    unsigned long long hits = 0;
+    unsigned long long misses = 0;
+    unsigned long long evictions = 0;
+    size_t size = 0;
+};
+
+/// @brief Caches the executable path of processes across captures.
+///        Entries are keyed by process id plus process start time,
+///        so a reused process id is not mistaken for the old process.
+class ProcessCache
+{
+private:
+    struct CachedProcess
+    {
+        unsigned long long startTime = 0;
+        std::string path;
+        /// @brief The last capture the process was looked up in.
+        unsigned long long lastSeen = 0;
+    };
+
+    std::unordered_map<unsigned long, CachedProcess> processes;
+    /// @brief Incremented on every capture.
+    unsigned long long capture = 0;
+    /// @brief Is it between `beginCapture` and `endCapture`?
+    bool capturing = false;
+    ProcessCacheStats stats;
+
+public:
+    /// @brief Start a new capture.
+    void beginCapture();
+    /// @brief Evict the processes that were not seen during the capture,
+    ///        as they have most likely exited.
+    void endCapture();
+
+    /// @brief Look up a process that was already validated during this capture,
+    ///        which needs no start time.
+    /// @return `nullptr` if the process has not been seen in this capture,
+    ///         or no capture is running (e.g. on a focus probe between captures,
+    ///         when the process id may have been reused since the last capture).
+    const std::string *findSeen(unsigned long pid);
+
+    /// @brief Look up a process, and mark it as seen in this capture.
+    /// @param pid Process id
+    /// @param startTime Process start time, in any unit
+    /// @return `nullptr` if the process is not cached, or the process id has been reused.
+    const std::string *find(unsigned long pid, unsigned long long startTime);
+
+    const std::string &insert(unsigned long pid, unsigned long long startTime, std::string path);
+
+    ProcessCacheStats getStats();
+};
+
+#endif /* MAIN_PROCESS_CACHE */
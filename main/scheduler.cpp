@@ -0,0 +1,99 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include "dev-logger.h"
+#include "scheduler.h"
+
+MissedTickPolicy parseMissedTickPolicy(const std::string &policy)
+{
+    if (policy == "skip")
+        return MissedTickSkip;
+    if (policy == "catchUp")
+        return MissedTickCatchUp;
+    throw std::invalid_argument("Unknown missed tick policy `" + policy + "`");
+}
+
+Scheduler::Scheduler(double period, MissedTickPolicy missedTickPolicy)
+    : missedTickPolicy(missedTickPolicy)
+{
+    if (period <= 0)
+        throw std::invalid_argument("Scheduler period must be positive");
+
+    this->period = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(period));
+    if (this->period.count() == 0)
+        this->period = Clock::duration(1);
+    this->start = Clock::now();
+}
+
+Scheduler::Clock::time_point Scheduler::nextDeadline()
+{
+    // Deadlines are derived from the start time instead of
+    // accumulated, so rounding errors do not add up either.
+    return this->start + this->period * this->nextIndex;
+}
+
+Tick Scheduler::wait()
+{
+    std::this_thread::sleep_until(this->nextDeadline());
+    return this->advance(Clock::now());
+}
+
+bool Scheduler::wait(const std::atomic<bool> &stopRequested)
+{
+    auto deadline = this->nextDeadline();
+    auto checkInterval = std::chrono::milliseconds(SCHEDULER_STOP_CHECK_MS);
+    while (!stopRequested.load())
+    {
+        auto now = Clock::now();
+        if (now >= deadline)
+        {
+            this->advance(now);
+            return true;
+        }
+        std::this_thread::sleep_until(std::min<Clock::time_point>(deadline, now + checkInterval));
+    }
+    return false;
+}
+
+Tick Scheduler::advance(Clock::time_point now)
+{
+    Tick tick;
+    tick.index = this->nextIndex;
+
+    auto deadline = this->nextDeadline();
+    if (now > deadline && this->missedTickPolicy == MissedTickSkip)
+    {
+        tick.skipped = (now - deadline) / this->period;
+        tick.index += tick.skipped;
+        deadline += this->period * tick.skipped;
+    }
+
+    tick.lateness = now > deadline
+                        ? std::chrono::duration_cast<std::chrono::nanoseconds>(now - deadline)
+                        : std::chrono::nanoseconds(0);
+    this->nextIndex = tick.index + 1;
+
+    this->stats.ticks++;
+    this->stats.skipped += tick.skipped;
+    this->stats.lastLateness = tick.lateness;
+    this->stats.totalLateness += tick.lateness;
+    if (tick.lateness > this->stats.maxLateness)
+        this->stats.maxLateness = tick.lateness;
+
+    DEBUG("Tick {} is {} us late", tick.index,
+          std::chrono::duration_cast<std::chrono::microseconds>(tick.lateness).count());
+    if (tick.skipped > 0)
+        WARN("Skipped {} ticks that are past their deadline", tick.skipped);
+
+    return tick;
+}
+
+SchedulerStats Scheduler::getStats()
+{
+    return this->stats;
+}
@@ -0,0 +1,81 @@
+#ifndef MAIN_SCHEDULER
+#define MAIN_SCHEDULER
+#include <atomic>
+#include <chrono>
+#include <string>
+
+/// Most time (in milliseconds) an interruptible wait sleeps
+/// before checking whether it should stop waiting.
+#define SCHEDULER_STOP_CHECK_MS 100
+
+enum MissedTickPolicy
+{
+    /// @brief Only run the latest missed tick, and drop the others.
+    MissedTickSkip,
+    /// @brief Run every missed tick back to back until caught up.
+    MissedTickCatchUp
+};
+
+/// @brief Convert the `missedTicks` config value into a `MissedTickPolicy`.
+///        Throws `std::invalid_argument` on unknown values.
+MissedTickPolicy parseMissedTickPolicy(const std::string &policy);
+
+struct Tick
+{
+    /// @brief Index of the tick since the scheduler started.
+    unsigned long long index = 0;
+    /// @brief How long after its deadline the tick fired.
+    std::chrono::nanoseconds lateness{0};
+    /// @brief Number of ticks skipped right before this one.
+    unsigned long long skipped = 0;
+};
+
+struct SchedulerStats
+{
+    unsigned long long ticks = 0;
+    unsigned long long skipped = 0;
+    std::chrono::nanoseconds lastLateness{0};
+    std::chrono::nanoseconds maxLateness{0};
+    std::chrono::nanoseconds totalLateness{0};
+};
+
+/// @brief Fires ticks at absolute deadlines (`start + index * period`)
+///        on a monotonic clock, so the time spent between ticks
+///        does not push the following ones back.
+class Scheduler
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+private:
+    Clock::duration period;
+    MissedTickPolicy missedTickPolicy;
+    Clock::time_point start;
+    unsigned long long nextIndex = 0;
+    SchedulerStats stats;
+
+public:
+    /// @param period Time (in seconds) between ticks. Can be less than a second.
+    /// @param missedTickPolicy What to do with ticks whose deadline has long passed.
+    Scheduler(double period, MissedTickPolicy missedTickPolicy = MissedTickSkip);
+
+    Clock::time_point nextDeadline();
+
+    /// @brief Sleep until the next deadline, then fire the tick.
+    ///        The first tick fires immediately.
+    Tick wait();
+
+    /// @brief Sleep until the next deadline, then fire the tick, unless
+    ///        `stopRequested` is set first. It is checked every
+    ///        `SCHEDULER_STOP_CHECK_MS`, so it can be set from a signal handler.
+    /// @return `false` if it stopped waiting, without firing the tick.
+    bool wait(const std::atomic<bool> &stopRequested);
+
+    /// @brief Fire the next tick without sleeping.
+    /// @param now The time the tick fires at
+    Tick advance(Clock::time_point now);
+
+    SchedulerStats getStats();
+};
+
+#endif /* MAIN_SCHEDULER */
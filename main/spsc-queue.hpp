@@ -0,0 +1,119 @@
+#ifndef MAIN_SPSC_QUEUE
+#define MAIN_SPSC_QUEUE
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+/// @brief Bounded, lock-free, single-producer/single-consumer ring buffer.
+///        Slots are allocated once and reused, items are filled in
+///        and consumed in place.
+template <typename T>
+class SpscQueue
+{
+private:
+    std::vector<T> slots;
+    /// @brief Index of the next slot to consume. Only written by the consumer.
+    alignas(64) std::atomic<size_t> head{0};
+    /// @brief Index of the next slot to fill in. Only written by the producer.
+    alignas(64) std::atomic<size_t> tail{0};
+
+    size_t next(size_t index) const;
+
+public:
+    /// @param capacity Maximum number of items in the queue.
+    explicit SpscQueue(size_t capacity);
+
+    /// @brief (Producer) Get the slot to fill in.
+    /// @return `nullptr` if the queue is full.
+    T *beginPush();
+    /// @brief (Producer) Publish the slot returned by `beginPush`.
+    void commitPush();
+    /// @brief (Producer) Move `item` into the queue.
+    /// @return `false` if the queue is full.
+    bool tryPush(T &&item);
+
+    /// @brief (Consumer) Get the oldest item.
+    /// @return `nullptr` if the queue is empty.
+    T *front();
+    /// @brief (Consumer) Release the item returned by `front`.
+    void pop();
+
+    size_t size() const;
+    bool empty() const;
+    size_t getCapacity() const;
+};
+
+template <typename T>
+SpscQueue<T>::SpscQueue(size_t capacity) : slots(capacity + 1) {}
+
+template <typename T>
+size_t SpscQueue<T>::next(size_t index) const
+{
+    return index + 1 == this->slots.size() ? 0 : index + 1;
+}
+
+template <typename T>
+T *SpscQueue<T>::beginPush()
+{
+    size_t tail = this->tail.load(std::memory_order_relaxed);
+    if (this->next(tail) == this->head.load(std::memory_order_acquire))
+        return nullptr;
+    return &this->slots[tail];
+}
+
+template <typename T>
+void SpscQueue<T>::commitPush()
+{
+    size_t tail = this->tail.load(std::memory_order_relaxed);
+    this->tail.store(this->next(tail), std::memory_order_release);
+}
+
+template <typename T>
+bool SpscQueue<T>::tryPush(T &&item)
+{
+    T *slot = this->beginPush();
+    if (slot == nullptr)
+        return false;
+    *slot = std::move(item);
+    this->commitPush();
+    return true;
+}
+
+template <typename T>
+T *SpscQueue<T>::front()
+{
+    size_t head = this->head.load(std::memory_order_relaxed);
+    if (head == this->tail.load(std::memory_order_acquire))
+        return nullptr;
+    return &this->slots[head];
+}
+
+template <typename T>
+void SpscQueue<T>::pop()
+{
+    size_t head = this->head.load(std::memory_order_relaxed);
+    this->head.store(this->next(head), std::memory_order_release);
+}
+
+template <typename T>
+size_t SpscQueue<T>::size() const
+{
+    size_t head = this->head.load(std::memory_order_acquire);
+    size_t tail = this->tail.load(std::memory_order_acquire);
+    return tail >= head ? tail - head : tail + this->slots.size() - head;
+}
+
+template <typename T>
+bool SpscQueue<T>::empty() const
+{
+    return this->size() == 0;
+}
+
+template <typename T>
+size_t SpscQueue<T>::getCapacity() const
+{
+    return this->slots.size() - 1;
+}
+
+#endif /* MAIN_SPSC_QUEUE */
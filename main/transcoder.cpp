@@ -0,0 +1,87 @@
+#include <cstddef>
+#include <string>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define TRANSCODER_SSE2 1
+#endif
+
+#include "transcoder.h"
+
+#define REPLACEMENT_CHARACTER 0xFFFD
+
+/// @brief Copy the longest ASCII-only prefix, 8 code units at a time.
+/// @return Number of code units copied.
+static size_t copyAsciiPrefix(const char16_t *in, size_t inLen, char *out)
+{
+    size_t i = 0;
+#ifdef TRANSCODER_SSE2
+    const __m128i nonAsciiMask = _mm_set1_epi16(static_cast<short>(0xFF80));
+    const __m128i zero = _mm_setzero_si128();
+
+    for (; i + 8 <= inLen; i += 8)
+    {
+        __m128i units = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i));
+        __m128i nonAscii = _mm_and_si128(units, nonAsciiMask);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi16(nonAscii, zero)) != 0xFFFF)
+            break;
+
+        // Every unit is below 0x80, so packing into bytes loses nothing.
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(out + i), _mm_packus_epi16(units, units));
+    }
+#endif
+    for (; i < inLen && in[i] < 0x80; i++)
+        out[i] = static_cast<char>(in[i]);
+    return i;
+}
+
+size_t utf16ToUtf8(const char16_t *in, size_t inLen, char *out)
+{
+    char *pOut = out;
+    size_t i = 0;
+
+    while (i < inLen)
+    {
+        // Window titles and paths are mostly ASCII.
+        size_t asciiLen = copyAsciiPrefix(in + i, inLen - i, pOut);
+        i += asciiLen;
+        pOut += asciiLen;
+        if (i == inLen)
+            break;
+
+        char32_t c = in[i++];
+
+        if (c >= 0xD800 && c <= 0xDBFF)
+        {
+            if (i < inLen && in[i] >= 0xDC00 && in[i] <= 0xDFFF)
+                c = 0x10000 + ((c - 0xD800) << 10) + (in[i++] - 0xDC00);
+            else
+                c = REPLACEMENT_CHARACTER;
+        }
+        else if (c >= 0xDC00 && c <= 0xDFFF)
+            c = REPLACEMENT_CHARACTER;
+
+        if (c < 0x80)
+            *pOut++ = static_cast<char>(c);
+        else if (c < 0x800)
+        {
+            *pOut++ = static_cast<char>(0xC0 | (c >> 6));
+            *pOut++ = static_cast<char>(0x80 | (c & 0x3F));
+        }
+        else if (c < 0x10000)
+        {
+            *pOut++ = static_cast<char>(0xE0 | (c >> 12));
+            *pOut++ = static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+            *pOut++ = static_cast<char>(0x80 | (c & 0x3F));
+        }
+        else
+        {
+            *pOut++ = static_cast<char>(0xF0 | (c >> 18));
+            *pOut++ = static_cast<char>(0x80 | ((c >> 12) & 0x3F));
+            *pOut++ = static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+            *pOut++ = static_cast<char>(0x80 | (c & 0x3F));
+        }
+    }
+
+    return pOut - out;
+}
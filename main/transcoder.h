@@ -0,0 +1,33 @@
+#ifndef MAIN_TRANSCODER
+#define MAIN_TRANSCODER
+#include <cstddef>
+#include <string>
+
+/// @brief Upper bound on the UTF-8 length (in bytes) of UTF-16 text.
+///        A code unit takes at most 3 bytes, a surrogate pair takes 4.
+/// @param utf16Len Number of UTF-16 code units
+inline size_t utf8MaxLen(size_t utf16Len)
+{
+    return utf16Len * 3;
+}
+
+/// @brief Transcode UTF-16 into UTF-8 without allocating.
+///        Unpaired surrogates are replaced with U+FFFD.
+/// @param in UTF-16 code units
+/// @param inLen Number of code units
+/// @param out Where the UTF-8 text will be put.
+///            Must hold at least `utf8MaxLen(inLen)` bytes.
+/// @return Length (in bytes) of the UTF-8 text.
+size_t utf16ToUtf8(const char16_t *in, size_t inLen, char *out);
+
+/// @brief Transcode UTF-16 into UTF-8, replacing the content of `out`.
+///        The capacity of `out` is reused.
+/// @tparam String `std::string` or `std::pmr::string`
+template <typename String>
+void utf16ToUtf8(const char16_t *in, size_t inLen, String *out)
+{
+    out->resize(utf8MaxLen(inLen));
+    out->resize(utf16ToUtf8(in, inLen, &(*out)[0]));
+}
+
+#endif /* MAIN_TRANSCODER */
@@ -1,3 +1,4 @@
+#include <cstdio>
 #include <memory>
 #include <string>
 #include <vector>
@@ -8,6 +9,7 @@
 #include "crypto.h"
 #include "dev-logger.h"
 #include "helpers.h"
+#include "key-cache.h"
 #include "logger.h"
 #include "pages.h"
 #include "ui.h"
@@ -248,14 +250,61 @@ NavInstruction LogDecryptionPage(ftxui::ScreenInteractive *screen, Config *confi
         basePage(ftxui::emptyElement(), "Processing...", "Decrypting Log Files..."));
     screen->Print();
 
+    // Unwrapped keys are kept for the lifetime of the process,
+    // and optionally saved encrypted with the password-based key.
+    static crypto::KeyCache keyCache;
+    std::string keyCachePath = config->decryption.keyCachePath.empty()
+                                   ? ""
+                                   : prepareAndProcessPath(config->decryption.keyCachePath).u8string();
+    if (!keyCachePath.empty() && fileExists(keyCachePath))
+    {
+        try
+        {
+            keyCache.loadFromFile(keyCachePath, symKey.get());
+        }
+        catch (const std::exception &ex)
+        {
+            WARN("Cannot load key cache from `{}`: {}", keyCachePath, ex.what());
+        }
+    }
+
     INFO("Decrypt log files from `{}` to `{}`", sourceDir, destDir);
-    logger::decryptLogFiles(sourceDir, destDir, asymKey.get());
+    logger::DecryptionOptions options;
+    options.threads = config->decryption.threads;
+    options.keyCache = &keyCache;
+    auto summary = logger::decryptLogFiles(sourceDir, destDir, asymKey.get(), options);
     screen->Clear();
 
+    if (!keyCachePath.empty())
+    {
+        try
+        {
+            keyCache.saveToFile(keyCachePath, symKey.get());
+        }
+        catch (const std::exception &ex)
+        {
+            SPDERROR("Cannot save key cache to `{}`: {}", keyCachePath, ex.what());
+        }
+    }
+
+    char throughput[32];
+    snprintf(throughput, sizeof(throughput), "%.1f", summary.getThroughput());
+    char keyCacheInfo[96];
+    snprintf(keyCacheInfo, sizeof(keyCacheInfo),
+             "\nKey cache hit rate %.0f%%, saving about %.1f seconds.",
+             summary.keyCache.getHitRate() * 100, summary.keyCache.getSavedSeconds());
+    std::string failed = summary.failed == 0
+                             ? ""
+                             : "\n" + std::to_string(summary.failed) +
+                                   " files could not be decrypted, see the log for details.";
+
     showInfo(screen,
              "Decryption Complete",
              "Log files from `" + sourceDir +
-                 "` has been decrypted to `" + destDir + "`.");
+                 "` has been decrypted to `" + destDir + "`.\n" +
+                 std::to_string(summary.results.size() - summary.failed) + " files decrypted with " +
+                 std::to_string(summary.threads) + " threads at " + throughput + " MB/s." +
+                 keyCacheInfo + failed);
 
     return navInstruction;
 }
@@ -0,0 +1,101 @@
+#include <algorithm>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "work-stealing-pool.h"
+
+WorkStealingPool::WorkStealingPool(unsigned int threads)
+{
+    if (threads == 0)
+        threads = std::thread::hardware_concurrency();
+    this->threadCount = threads == 0 ? 1 : threads;
+
+    for (unsigned int i = 0; i < this->threadCount; i++)
+        this->workers.emplace_back(new Worker());
+}
+
+bool WorkStealingPool::takeOwn(size_t index, std::function<void()> *task)
+{
+    Worker &worker = *this->workers[index];
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    if (worker.tasks.empty())
+        return false;
+
+    *task = std::move(worker.tasks.front());
+    worker.tasks.pop_front();
+    return true;
+}
+
+bool WorkStealingPool::steal(size_t thief, std::function<void()> *task)
+{
+    for (size_t i = 1; i < this->workers.size(); i++)
+    {
+        Worker &victim = *this->workers[(thief + i) % this->workers.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (victim.tasks.empty())
+            continue;
+
+        *task = std::move(victim.tasks.back());
+        victim.tasks.pop_back();
+        return true;
+    }
+    return false;
+}
+
+void WorkStealingPool::work(size_t index)
+{
+    std::function<void()> task;
+
+    // No task is added while running,
+    // so once every deque is empty, the work is done.
+    while (this->takeOwn(index, &task) || this->steal(index, &task))
+        task();
+}
+
+void WorkStealingPool::run(std::vector<std::function<void()>> tasks)
+{
+    for (size_t i = 0; i < tasks.size(); i++)
+        this->workers[i % this->workers.size()]->tasks.push_back(std::move(tasks[i]));
+
+    std::mutex errorMutex;
+    std::exception_ptr error;
+    auto guardedWork = [&](size_t index)
+    {
+        // A failed task does not stop the thread from taking the next one.
+        while (true)
+        {
+            try
+            {
+                this->work(index);
+                return;
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(errorMutex);
+                if (!error)
+                    error = std::current_exception();
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    size_t threadCount = std::min(this->workers.size(), tasks.size());
+    for (size_t i = 1; i < threadCount; i++)
+        threads.emplace_back(guardedWork, i);
+    guardedWork(0);
+
+    for (auto &thread : threads)
+        thread.join();
+
+    if (error)
+        std::rethrow_exception(error);
+}
+
+unsigned int WorkStealingPool::getThreadCount()
+{
+    return this->threadCount;
+}
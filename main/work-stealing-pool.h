@@ -0,0 +1,44 @@
+#ifndef MAIN_WORK_STEALING_POOL
+#define MAIN_WORK_STEALING_POOL
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/// @brief Runs a batch of independent tasks on a fixed number of threads.
+///        Tasks are dealt round-robin to per-thread deques. A thread takes
+///        its own tasks from the front, and when it runs dry, steals from
+///        the back of the others' deques.
+class WorkStealingPool
+{
+private:
+    struct Worker
+    {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    unsigned int threadCount = 1;
+    std::vector<std::unique_ptr<Worker>> workers;
+
+    bool takeOwn(size_t index, std::function<void()> *task);
+    bool steal(size_t thief, std::function<void()> *task);
+    void work(size_t index);
+
+public:
+    /// @param threads Number of threads. `0` uses one per hardware thread.
+    WorkStealingPool(unsigned int threads = 0);
+    WorkStealingPool(const WorkStealingPool &) = delete;
+    WorkStealingPool &operator=(const WorkStealingPool &) = delete;
+
+    /// @brief Run every task, and wait for all of them to finish.
+    ///        The calling thread is one of the workers.
+    ///        If tasks throw, the first exception is rethrown afterwards.
+    /// @param tasks Tasks, longest first, so they start first.
+    void run(std::vector<std::function<void()>> tasks);
+
+    unsigned int getThreadCount();
+};
+
+#endif /* MAIN_WORK_STEALING_POOL */
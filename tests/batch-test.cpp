@@ -0,0 +1,111 @@
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "encrypted-log.h"
+#include "log-reader.h"
+#include "test.h"
+
+/// @brief Number of frames of each type in a log file.
+static std::map<logger::DataType, int> countFrames(const std::filesystem::path &path)
+{
+    std::map<logger::DataType, int> counts;
+    logger::LogReader reader(path);
+    logger::LogFrame frame;
+    while (reader.nextHeader(&frame))
+        counts[frame.type]++;
+    return counts;
+}
+
+static bool hasEntries(const std::vector<std::string> &entries, int first, int count)
+{
+    if (entries.size() != static_cast<size_t>(count))
+        return false;
+    for (int i = 0; i < count; i++)
+        if (!isEntry(entries[i], first + i))
+            return false;
+    return true;
+}
+
+static void testBatchesAcrossKeyRotations(const std::filesystem::path &dir, crypto::AsymKey *asymKey)
+{
+    std::filesystem::remove_all(dir / "logs");
+    auto config = makeEncryptedConfig(dir, asymKey);
+    // The key rotates every 4 entries, before a batch of 5 is full,
+    // so every batch is cut short by a rotation.
+    config.batch.entries = 5;
+    config.encryption.keyGenRate = 3;
+    {
+        logger::Logger logger(&config);
+        for (int i = 0; i < 23; i++)
+            logger.write(makeEntry(1704110400 + i, i));
+        // The last 3 entries are still batched, and written when the logger stops.
+    }
+    auto path = findLogFile(dir);
+
+    auto counts = countFrames(path);
+    CHECK(counts[logger::DataTypeJson] == 0);
+    CHECK(counts[logger::DataTypeSymKey] == 1);
+    CHECK(counts[logger::DataTypeSegmentKey] == 5);
+    CHECK(counts[logger::DataTypeJsonBatch] == 6);
+    CHECK(hasEntries(decryptEntries(path, asymKey), 0, 23));
+    CHECK(hasEntries(decryptEntries(path, asymKey, 4), 0, 23));
+}
+
+static void testBatchesAcrossDays(const std::filesystem::path &dir, crypto::AsymKey *asymKey)
+{
+    std::filesystem::remove_all(dir / "logs");
+    auto config = makeEncryptedConfig(dir, asymKey);
+    config.batch.entries = 10;
+    {
+        logger::Logger logger(&config);
+        for (int i = 0; i < 4; i++)
+            logger.write(makeEntry(1704110400 + i, i));
+        // The batched entries go to the file of the day they were captured,
+        // and the next day's file gets a key of its own.
+        for (int i = 4; i < 7; i++)
+            logger.write(makeEntry(1704110400 + 86400 + i, i));
+    }
+
+    std::vector<std::filesystem::path> paths;
+    for (auto &file : std::filesystem::directory_iterator(dir / "logs"))
+        paths.push_back(file.path());
+    std::sort(paths.begin(), paths.end());
+    CHECK(paths.size() == 2);
+    if (paths.size() != 2)
+        return;
+    CHECK(hasEntries(decryptEntries(paths[0], asymKey), 0, 4));
+    CHECK(hasEntries(decryptEntries(paths[1], asymKey), 4, 3));
+    CHECK(countFrames(paths[1])[logger::DataTypeSymKey] == 1);
+}
+
+static void testFlushWritesPendingBatch(const std::filesystem::path &dir, crypto::AsymKey *asymKey)
+{
+    std::filesystem::remove_all(dir / "logs");
+    auto config = makeEncryptedConfig(dir, asymKey);
+    config.batch.entries = 10;
+    logger::Logger logger(&config);
+    for (int i = 0; i < 3; i++)
+        logger.write(makeEntry(1704110400 + i, i));
+
+    // As on shutdown, the batch is written without waiting for it to fill up.
+    logger.flush();
+    auto path = findLogFile(dir);
+    CHECK(countFrames(path)[logger::DataTypeJsonBatch] == 1);
+    CHECK(hasEntries(decryptEntries(path, asymKey), 0, 3));
+}
+
+int main()
+{
+    auto dir = makeTestDirectory("batch-test");
+    crypto::AsymKey asymKey;
+    asymKey.generate();
+
+    testBatchesAcrossKeyRotations(dir, &asymKey);
+    testBatchesAcrossDays(dir, &asymKey);
+    testFlushWritesPendingBatch(dir, &asymKey);
+
+    std::filesystem::remove_all(dir);
+    return TEST_RESULT;
+}
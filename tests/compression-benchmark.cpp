@@ -0,0 +1,117 @@
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "compression.h"
+#include "test.h"
+
+/// Length (in bytes) of the batches compressed together, as `batch.bytes` defaults to.
+#define BENCHMARK_BATCH_LEN 65536
+
+/// @brief Snapshot entries as the logger writes them: a dozen apps
+///        whose paths repeat, and whose titles change now and then.
+static std::vector<std::string> makeEntries(int count)
+{
+    const char *apps[][2] = {
+        {"C:\\\\Program Files\\\\Google\\\\Chrome\\\\Application\\\\chrome.exe", "Inbox (%d) - Gmail - Google Chrome"},
+        {"C:\\\\Windows\\\\explorer.exe", "Documents"},
+        {"C:\\\\Users\\\\someone\\\\AppData\\\\Local\\\\Programs\\\\Microsoft VS Code\\\\Code.exe", "logger.cpp - watchful-owl - Visual Studio Code"},
+        {"C:\\\\Program Files\\\\Microsoft Office\\\\root\\\\Office16\\\\WINWORD.EXE", "Report draft %d - Word"},
+        {"C:\\\\Program Files\\\\Microsoft Office\\\\root\\\\Office16\\\\OUTLOOK.EXE", "Inbox - someone@example.com - Outlook"},
+        {"C:\\\\Users\\\\someone\\\\AppData\\\\Local\\\\Discord\\\\app-1.0.9013\\\\Discord.exe", "#general | Server - Discord"},
+        {"C:\\\\Program Files\\\\WindowsApps\\\\Spotify.exe", "Song %d - Artist"},
+        {"C:\\\\Windows\\\\System32\\\\cmd.exe", "Command Prompt"},
+        {"C:\\\\Program Files\\\\Notepad++\\\\notepad++.exe", "*new %d - Notepad++"},
+        {"C:\\\\Windows\\\\System32\\\\Taskmgr.exe", "Task Manager"},
+        {"C:\\\\Program Files\\\\Mozilla Firefox\\\\firefox.exe", "Search results %d - Mozilla Firefox"},
+        {"C:\\\\Program Files\\\\Slack\\\\slack.exe", "Slack | team | Workspace"},
+    };
+
+    std::mt19937 random(42);
+    std::vector<std::string> entries;
+    char title[256];
+    for (int i = 0; i < count; i++)
+    {
+        std::string entry = "{\"apps\":[";
+        for (size_t app = 0; app < sizeof(apps) / sizeof(apps[0]); app++)
+        {
+            std::snprintf(title, sizeof(title), apps[app][1], static_cast<int>(random() % 20));
+            entry += std::string(app == 0 ? "" : ",") + "{\"isActive\":" +
+                     (random() % 12 == app ? "true" : "false") + ",\"path\":\"" + apps[app][0] +
+                     "\",\"title\":\"" + title + "\"}";
+        }
+        entry += "],\"time\":" + std::to_string(1704067200 + i * 60) + "}";
+        entries.push_back(entry);
+    }
+    return entries;
+}
+
+/// @brief Print the compression ratio, and the throughput (in MB/s of plain data)
+///        of compressing every message `rounds` times, then of decompressing them.
+template <typename Compress>
+static void run(const char *name, int level, const std::vector<std::string> &messages,
+                int rounds, Compress compress)
+{
+    size_t plainLen = 0, deflatedLen = 0;
+    std::vector<std::string> deflated(messages.size());
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; round++)
+        for (size_t i = 0; i < messages.size(); i++)
+        {
+            deflated[i] = compress(messages[i]);
+            plainLen += messages[i].size();
+            deflatedLen += deflated[i].size();
+        }
+    double deflateSeconds = secondsSince(start);
+
+    std::string inflated;
+    start = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; round++)
+        for (auto &message : deflated)
+            logger::inflateData(reinterpret_cast<const unsigned char *>(message.data()), message.size(),
+                                BENCHMARK_BATCH_LEN * 2, &inflated);
+    double inflateSeconds = secondsSince(start);
+
+    std::printf("%-28s level %d  ratio %5.2f  deflate %7.1f MB/s  inflate %7.1f MB/s\n",
+                name, level, static_cast<double>(plainLen) / deflatedLen,
+                plainLen / deflateSeconds / 1e6, plainLen / inflateSeconds / 1e6);
+}
+
+int main(int argc, char **argv)
+{
+    // The workload is scaled by the first argument.
+    int scale = argc > 1 ? std::atoi(argv[1]) : 100;
+    int rounds = scale;
+
+    auto entries = makeEntries(1000);
+    std::vector<std::string> batches(1);
+    for (auto &entry : entries)
+    {
+        if (batches.back().size() + entry.size() > BENCHMARK_BATCH_LEN)
+            batches.emplace_back();
+        batches.back() += entry;
+    }
+
+    for (int level = DEFLATE_MIN_LEVEL; level <= DEFLATE_MAX_LEVEL; level++)
+    {
+        logger::Compressor compressor(level);
+        auto reused = [&](const std::string &message) -> const std::string &
+        {
+            return compressor.compress(reinterpret_cast<const unsigned char *>(message.data()), message.size());
+        };
+        std::string out;
+        auto oneOff = [&](const std::string &message) -> const std::string &
+        {
+            logger::deflateData(reinterpret_cast<const unsigned char *>(message.data()), message.size(), level, &out);
+            return out;
+        };
+
+        run("entries, reused Compressor", level, entries, rounds, reused);
+        run("entries, Deflator per entry", level, entries, rounds, oneOff);
+        run("64 KB batches, reused", level, batches, rounds, reused);
+        run("64 KB batches, per batch", level, batches, rounds, oneOff);
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,143 @@
+#include <string>
+#include <vector>
+
+#include "compression.h"
+#include "encrypted-log.h"
+#include "log-reader.h"
+#include "test.h"
+
+static std::string makeEntryText(int index)
+{
+    return "{\"apps\":[{\"isActive\":true,\"path\":\"C:\\\\Program Files\\\\App " + std::to_string(index % 7) +
+           "\\\\app.exe\",\"title\":\"Document " + std::to_string(index) + " - App\"}],\"time\":" +
+           std::to_string(1704110400 + index) + "}";
+}
+
+static void testCompressorRoundTrip()
+{
+    for (int level = DEFLATE_MIN_LEVEL; level <= DEFLATE_MAX_LEVEL; level++)
+    {
+        logger::Compressor compressor(level);
+        bool roundTrips = true, matchesOneOff = true;
+        std::string expected, inflated;
+        for (int i = 0; i < 200; i++)
+        {
+            // Messages of every length, from empty to a few batches long.
+            std::string text;
+            while (text.size() < static_cast<size_t>(i * i))
+                text += makeEntryText(i);
+            auto data = reinterpret_cast<const unsigned char *>(text.data());
+
+            // Each message stands on its own, nothing carries over from the one before.
+            auto &deflated = compressor.compress(data, text.size());
+            roundTrips = roundTrips &&
+                         logger::inflateData(reinterpret_cast<const unsigned char *>(deflated.data()),
+                                             deflated.size(), text.size(), &inflated) &&
+                         inflated == text;
+            logger::deflateData(data, text.size(), level, &expected);
+            matchesOneOff = matchesOneOff && deflated == expected;
+        }
+        CHECK(roundTrips);
+        CHECK(matchesOneOff);
+    }
+
+    // Out of range levels are clamped, as with `deflateData`.
+    std::string text = makeEntryText(0), expected;
+    auto data = reinterpret_cast<const unsigned char *>(text.data());
+    logger::deflateData(data, text.size(), DEFLATE_MAX_LEVEL, &expected);
+    CHECK(logger::Compressor(DEFLATE_MAX_LEVEL + 5).compress(data, text.size()) == expected);
+}
+
+static void testInflateLimits()
+{
+    std::string text(100000, 'a'), inflated;
+    logger::Compressor compressor(6);
+    auto &deflated = compressor.compress(reinterpret_cast<const unsigned char *>(text.data()), text.size());
+    auto data = reinterpret_cast<const unsigned char *>(deflated.data());
+
+    // A frame may not decompress to more than it is allowed to hold...
+    CHECK(!logger::inflateData(data, deflated.size(), text.size() - 1, &inflated));
+    // ... and a truncated one is rejected.
+    CHECK(!logger::inflateData(data, deflated.size() / 2, text.size(), &inflated));
+    CHECK(logger::inflateData(data, deflated.size(), text.size(), &inflated) && inflated == text);
+}
+
+static void testCompressedLogFile(const std::filesystem::path &dir, crypto::AsymKey *asymKey)
+{
+    for (unsigned int batchEntries : {1, 8})
+    {
+        std::filesystem::remove_all(dir / "logs");
+        auto config = makeEncryptedConfig(dir, asymKey);
+        config.encryption.compressionLevel = 6;
+        config.encryption.keyGenRate = 10;
+        config.batch.entries = batchEntries;
+        {
+            logger::Logger logger(&config);
+            for (int i = 0; i < 50; i++)
+                logger.write(makeEntry(1704110400 + i, i));
+        }
+        auto path = findLogFile(dir);
+
+        int frames = 0, compressedFrames = 0;
+        {
+            logger::LogReader reader(path);
+            logger::LogFrame frame;
+            while (reader.nextHeader(&frame))
+                if (frame.type == logger::DataTypeJson || frame.type == logger::DataTypeJsonBatch)
+                {
+                    frames++;
+                    compressedFrames += frame.compressed;
+                }
+        }
+        // Single short entries may not shrink, batches of them do.
+        CHECK(frames > 0);
+        CHECK(batchEntries == 1 || compressedFrames == frames);
+
+        auto entries = decryptEntries(path, asymKey);
+        bool readBack = entries.size() == 50;
+        for (int i = 0; readBack && i < 50; i++)
+            readBack = isEntry(entries[i], i);
+        CHECK(readBack);
+    }
+}
+
+static void testQueryCompressedFiles(const std::filesystem::path &dir, crypto::AsymKey *asymKey)
+{
+    // Files are decrypted into memory in batches sized by their plaintext,
+    // which is larger than the files, and still passed on in order.
+    std::filesystem::remove_all(dir / "logs");
+    auto config = makeEncryptedConfig(dir, asymKey);
+    config.encryption.compressionLevel = 9;
+    config.batch.entries = 16;
+    {
+        logger::Logger logger(&config);
+        for (int i = 0; i < 120; i++)
+            logger.write(makeEntry(1704110400 + i / 40 * 86400 + i, i));
+    }
+
+    CollectingLogSink sink;
+    logger::DecryptionOptions options;
+    options.threads = 2;
+    auto summary = logger::queryLogFiles(dir / "logs", asymKey, &sink, options);
+    CHECK(summary.results.size() == 3);
+    CHECK(summary.failed == 0);
+    bool inOrder = sink.entries.size() == 120;
+    for (int i = 0; inOrder && i < 120; i++)
+        inOrder = isEntry(sink.entries[i], i);
+    CHECK(inOrder);
+}
+
+int main()
+{
+    testCompressorRoundTrip();
+    testInflateLimits();
+
+    auto dir = makeTestDirectory("compression-test");
+    crypto::AsymKey asymKey;
+    asymKey.generate();
+    testCompressedLogFile(dir, &asymKey);
+    testQueryCompressedFiles(dir, &asymKey);
+
+    std::filesystem::remove_all(dir);
+    return TEST_RESULT;
+}
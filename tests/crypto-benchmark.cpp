@@ -0,0 +1,84 @@
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "crypto.h"
+#include "test.h"
+
+/// @brief Print the records/s and MB/s of running `crypt` on `records` records.
+template <typename Crypt>
+static void run(const char *name, size_t recordLen, int records, Crypt crypt)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < records; i++)
+        crypt(i);
+    double seconds = secondsSince(start);
+    std::printf("%-38s %6zu B  %10.0f records/s  %8.1f MB/s\n",
+                name, recordLen, records / seconds, records * recordLen / seconds / 1e6);
+}
+
+/// @brief Compare a long-lived key, keyed once, with a key (and so cipher objects
+///        and a key schedule) made anew for every record, as before they were reused.
+static void runRecordLen(size_t recordLen, int records)
+{
+    crypto::SymKey symKey;
+    symKey.generateRandom();
+    std::vector<CryptoPP::byte> secret(symKey.getSecretLen());
+    symKey.getSecret(secret.data(), secret.size());
+
+    std::vector<CryptoPP::byte> plain(recordLen, 'x');
+    std::vector<CryptoPP::byte> cbcCipher(symKey.calculateCipherLen(recordLen));
+    std::vector<CryptoPP::byte> gcmCipher(recordLen + symKey.getTagLen());
+    std::vector<CryptoPP::byte> decrypted(cbcCipher.size());
+
+    run("CBC encrypt, reused key", recordLen, records, [&](int)
+        { symKey.encrypt(plain.data(), plain.size(), cbcCipher.data(), cbcCipher.size()); });
+    run("CBC encrypt, new key per record", recordLen, records, [&](int)
+        {
+            crypto::SymKey fresh(secret.data(), secret.size());
+            fresh.encrypt(plain.data(), plain.size(), cbcCipher.data(), cbcCipher.size());
+        });
+    run("CBC decrypt, reused key", recordLen, records, [&](int)
+        { symKey.decrypt(cbcCipher.data(), cbcCipher.size(), decrypted.data(), decrypted.size()); });
+    run("CBC decrypt, new key per record", recordLen, records, [&](int)
+        {
+            crypto::SymKey fresh(secret.data(), secret.size());
+            fresh.decrypt(cbcCipher.data(), cbcCipher.size(), decrypted.data(), decrypted.size());
+        });
+
+    run("GCM encrypt, reused key", recordLen, records, [&](int i)
+        {
+            std::copy(plain.begin(), plain.end(), gcmCipher.begin());
+            symKey.encryptAuthenticated(gcmCipher.data(), recordLen, i, nullptr, 0);
+        });
+    run("GCM encrypt, new key per record", recordLen, records, [&](int i)
+        {
+            crypto::SymKey fresh(secret.data(), secret.size());
+            std::copy(plain.begin(), plain.end(), gcmCipher.begin());
+            fresh.encryptAuthenticated(gcmCipher.data(), recordLen, i, nullptr, 0);
+        });
+    // Every record is decrypted with the counter of the last one encrypted.
+    unsigned long long counter = records - 1;
+    run("GCM decrypt, reused key", recordLen, records, [&](int)
+        {
+            symKey.decryptAuthenticated(gcmCipher.data(), gcmCipher.size(), counter, nullptr, 0,
+                                        decrypted.data(), decrypted.size());
+        });
+    run("GCM decrypt, new key per record", recordLen, records, [&](int)
+        {
+            crypto::SymKey fresh(secret.data(), secret.size());
+            fresh.decryptAuthenticated(gcmCipher.data(), gcmCipher.size(), counter, nullptr, 0,
+                                       decrypted.data(), decrypted.size());
+        });
+}
+
+int main(int argc, char **argv)
+{
+    // The workload is scaled by the first argument.
+    int scale = argc > 1 ? std::atoi(argv[1]) : 100;
+
+    // Typical entries, and large snapshots or batches.
+    runRecordLen(1024, 1000 * scale);
+    runRecordLen(102400, 10 * scale);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,287 @@
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "crypto.h"
+#include "encrypted-log.h"
+#include "log-reader.h"
+#include "test.h"
+
+/// Number of entries in each log file of the test.
+#define CRYPTO_TEST_ENTRIES 12
+
+static std::vector<CryptoPP::byte> makePlain(size_t len)
+{
+    std::vector<CryptoPP::byte> plain(len);
+    for (size_t i = 0; i < len; i++)
+        plain[i] = static_cast<CryptoPP::byte>(i * 31 + 7);
+    return plain;
+}
+
+static void testCbcRoundTrip()
+{
+    crypto::SymKey symKey;
+    symKey.generateRandom();
+
+    // Lengths around the AES block size, where the padding changes.
+    for (size_t len : {0, 1, 15, 16, 17, 1000})
+    {
+        auto plain = makePlain(len);
+        std::vector<CryptoPP::byte> cipher(symKey.calculateCipherLen(len));
+        symKey.encrypt(plain.data(), plain.size(), cipher.data(), cipher.size());
+
+        std::vector<CryptoPP::byte> decrypted(cipher.size());
+        size_t decryptedLen = 0;
+        symKey.decrypt(cipher.data(), cipher.size(), decrypted.data(), decrypted.size(), &decryptedLen);
+        decrypted.resize(decryptedLen);
+        CHECK(decrypted == plain);
+    }
+
+    // A cipher that is not a whole number of blocks was cut short.
+    auto plain = makePlain(100);
+    std::vector<CryptoPP::byte> cipher(symKey.calculateCipherLen(plain.size()));
+    symKey.encrypt(plain.data(), plain.size(), cipher.data(), cipher.size());
+    std::vector<CryptoPP::byte> decrypted(cipher.size());
+    CHECK_THROWS(crypto::DecryptionError,
+                 symKey.decrypt(cipher.data(), cipher.size() - 1, decrypted.data(), decrypted.size()));
+}
+
+/// @brief Decrypt what `encryptAuthenticated` gave for `makePlain(plainLen)`
+///        with `counter` and `aad`, after it has been changed by `tamper`.
+/// @return `true` if it decrypts to the plain data, `false` if it is rejected.
+template <typename Tamper>
+static bool decryptsAfter(crypto::SymKey *symKey, size_t plainLen, Tamper tamper)
+{
+    unsigned long long counter = 5;
+    CryptoPP::byte aad[4] = {0x00, 0x00, 0x01, 0x00};
+    auto plain = makePlain(plainLen);
+    std::vector<CryptoPP::byte> buffer(plain);
+    buffer.resize(plainLen + symKey->getTagLen());
+    symKey->encryptAuthenticated(buffer.data(), plainLen, counter, aad, sizeof(aad));
+    CHECK(plainLen == 0 || std::memcmp(buffer.data(), plain.data(), plainLen) != 0);
+
+    tamper(&buffer, &counter, aad);
+    std::vector<CryptoPP::byte> decrypted(buffer.size());
+    try
+    {
+        decrypted.resize(symKey->decryptAuthenticated(buffer.data(), buffer.size(), counter,
+                                                      aad, sizeof(aad),
+                                                      decrypted.data(), decrypted.size()));
+    }
+    catch (const crypto::DecryptionError &)
+    {
+        return false;
+    }
+    CHECK(decrypted == plain);
+    return true;
+}
+
+static void testGcmRoundTrip()
+{
+    crypto::SymKey symKey;
+    symKey.generateRandom();
+    auto untouched = [](std::vector<CryptoPP::byte> *, unsigned long long *, CryptoPP::byte *) {};
+
+    for (size_t len : {0, 1, 16, 1000})
+        CHECK(decryptsAfter(&symKey, len, untouched));
+
+    // Any change to the cipher, the tag, the associated data (the frame
+    // header) or the nonce (the position of the entry) is rejected.
+    CHECK(!decryptsAfter(&symKey, 100, [](auto *buffer, auto *, auto *) { (*buffer)[50] ^= 0x01; }));
+    CHECK(!decryptsAfter(&symKey, 100, [](auto *buffer, auto *, auto *) { buffer->back() ^= 0x80; }));
+    CHECK(!decryptsAfter(&symKey, 100, [](auto *, auto *, auto *aad) { aad[0] ^= 0x80; }));
+    CHECK(!decryptsAfter(&symKey, 100, [](auto *, auto *counter, auto *) { (*counter)++; }));
+    CHECK(!decryptsAfter(&symKey, 100, [](auto *buffer, auto *, auto *) { buffer->pop_back(); }));
+
+    // So is a cipher encrypted with another key.
+    crypto::SymKey otherKey;
+    otherKey.generateRandom();
+    auto plain = makePlain(100);
+    std::vector<CryptoPP::byte> buffer(plain);
+    buffer.resize(plain.size() + symKey.getTagLen());
+    otherKey.encryptAuthenticated(buffer.data(), plain.size(), 0, nullptr, 0);
+    std::vector<CryptoPP::byte> decrypted(buffer.size());
+    CHECK_THROWS(crypto::DecryptionError,
+                 symKey.decryptAuthenticated(buffer.data(), buffer.size(), 0, nullptr, 0,
+                                             decrypted.data(), decrypted.size()));
+}
+
+/// @brief Encrypt many records in a row with one key, as a logger does,
+///        and decrypt them in a row with another key of the same secret,
+///        as a decryptor does. Keyed cipher objects are reused across the
+///        records, so nothing of a record may leak into the next one.
+static void testManyRecordsWithOneKey()
+{
+    crypto::SymKey writerKey;
+    writerKey.generateRandom();
+    std::vector<CryptoPP::byte> secret(writerKey.getSecretLen());
+    writerKey.getSecret(secret.data(), secret.size());
+    crypto::SymKey readerKey(secret.data(), secret.size());
+
+    std::vector<std::vector<CryptoPP::byte>> plains, cbcCiphers, gcmCiphers;
+    for (size_t i = 0; i < 1000; i++)
+    {
+        auto plain = makePlain(i % 97 * 13);
+        plain.push_back(static_cast<CryptoPP::byte>(i));
+        plains.push_back(plain);
+
+        std::vector<CryptoPP::byte> cipher(writerKey.calculateCipherLen(plain.size()));
+        writerKey.encrypt(plain.data(), plain.size(), cipher.data(), cipher.size());
+        cbcCiphers.push_back(cipher);
+
+        // The modes share the key, so they are interleaved too.
+        cipher = plain;
+        cipher.resize(plain.size() + writerKey.getTagLen());
+        writerKey.encryptAuthenticated(cipher.data(), plain.size(), i, nullptr, 0);
+        gcmCiphers.push_back(cipher);
+    }
+
+    // A fresh IV for every CBC record, so equal records do not look equal.
+    std::vector<CryptoPP::byte> again(cbcCiphers[0].size());
+    writerKey.encrypt(plains[0].data(), plains[0].size(), again.data(), again.size());
+    CHECK(again != cbcCiphers[0]);
+
+    bool cbcRoundTrips = true, gcmRoundTrips = true;
+    std::vector<CryptoPP::byte> decrypted;
+    for (size_t i = 0; i < plains.size(); i++)
+    {
+        decrypted.resize(cbcCiphers[i].size());
+        size_t decryptedLen = 0;
+        readerKey.decrypt(cbcCiphers[i].data(), cbcCiphers[i].size(),
+                          decrypted.data(), decrypted.size(), &decryptedLen);
+        decrypted.resize(decryptedLen);
+        cbcRoundTrips = cbcRoundTrips && decrypted == plains[i];
+
+        decrypted.resize(gcmCiphers[i].size());
+        decrypted.resize(readerKey.decryptAuthenticated(gcmCiphers[i].data(), gcmCiphers[i].size(),
+                                                        i, nullptr, 0,
+                                                        decrypted.data(), decrypted.size()));
+        gcmRoundTrips = gcmRoundTrips && decrypted == plains[i];
+    }
+    CHECK(cbcRoundTrips);
+    CHECK(gcmRoundTrips);
+
+    // A record that fails to decrypt leaves the key usable for the next ones.
+    auto tampered = gcmCiphers[10];
+    tampered[0] ^= 0x01;
+    decrypted.resize(tampered.size());
+    CHECK_THROWS(crypto::DecryptionError,
+                 readerKey.decryptAuthenticated(tampered.data(), tampered.size(), 10, nullptr, 0,
+                                                decrypted.data(), decrypted.size()));
+    decrypted.resize(readerKey.decryptAuthenticated(gcmCiphers[11].data(), gcmCiphers[11].size(),
+                                                    11, nullptr, 0,
+                                                    decrypted.data(), decrypted.size()));
+    CHECK(decrypted == plains[11]);
+}
+
+/// @brief Offsets (in bytes) of the headers of the entry frames of a log file.
+static std::vector<unsigned long long> findEntryFrames(const std::filesystem::path &path, char *version)
+{
+    std::vector<unsigned long long> offsets;
+    logger::LogReader reader(path);
+    *version = reader.getVersion();
+    logger::LogFrame frame;
+    while (reader.nextHeader(&frame))
+        if (frame.type == logger::DataTypeJson)
+            offsets.push_back(frame.offset);
+    return offsets;
+}
+
+static bool hasEveryEntry(const std::vector<std::string> &entries, int skipped = -1)
+{
+    size_t expected = skipped < 0 ? CRYPTO_TEST_ENTRIES : CRYPTO_TEST_ENTRIES - 1;
+    if (entries.size() != expected)
+        return false;
+    for (int i = 0, j = 0; i < CRYPTO_TEST_ENTRIES; i++)
+        if (i != skipped && !isEntry(entries[j++], i))
+            return false;
+    return true;
+}
+
+/// @brief Write `CRYPTO_TEST_ENTRIES` entries with key rotations,
+///        to a new log file, or to one that only holds `version`.
+static std::filesystem::path writeLogFile(const std::filesystem::path &dir, crypto::AsymKey *asymKey,
+                                          char version = 0)
+{
+    std::filesystem::remove_all(dir / "logs");
+    std::filesystem::create_directories(dir / "logs");
+    if (version != 0)
+        std::ofstream(dir / "logs" / "20240101.json.log.enc", std::ios::binary).put(version);
+
+    auto config = makeEncryptedConfig(dir, asymKey);
+    config.encryption.keyGenRate = 4;
+    {
+        logger::Logger logger(&config);
+        for (int i = 0; i < CRYPTO_TEST_ENTRIES; i++)
+            logger.write(makeEntry(1704110400 + i, i));
+    }
+    return findLogFile(dir);
+}
+
+static void testCbcLogFile(const std::filesystem::path &dir, crypto::AsymKey *asymKey)
+{
+    // Files of the older version keep it when appended to.
+    auto path = writeLogFile(dir, asymKey, ENC_LOGFILE_VERSION_CBC);
+    char version = 0;
+    CHECK(findEntryFrames(path, &version).size() == CRYPTO_TEST_ENTRIES);
+    CHECK(version == ENC_LOGFILE_VERSION_CBC);
+    CHECK(hasEveryEntry(decryptEntries(path, asymKey)));
+}
+
+static void testGcmLogFile(const std::filesystem::path &dir, crypto::AsymKey *asymKey)
+{
+    auto path = writeLogFile(dir, asymKey);
+    char version = 0;
+    auto frames = findEntryFrames(path, &version);
+    CHECK(frames.size() == CRYPTO_TEST_ENTRIES);
+    CHECK(version == ENC_LOGFILE_VERSION_GCM);
+    CHECK(hasEveryEntry(decryptEntries(path, asymKey)));
+
+    std::string intact;
+    {
+        std::ifstream file(path, std::ios::binary);
+        intact.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+    auto tamper = [&](size_t offset, char mask)
+    {
+        std::string tampered = intact;
+        tampered[offset] ^= mask;
+        std::ofstream(path, std::ios::binary).write(tampered.data(), tampered.size());
+        return decryptEntries(path, asymKey);
+    };
+
+    // An altered entry is skipped rather than decrypted to garbage,
+    // and the entries around it are still read. The header is authenticated
+    // too, so marking the entry as compressed is caught as well.
+    int target = 5;
+    auto header = frames[target];
+    auto dataBegin = header + FRAME_HEADER_LEN;
+    logger::LogFrame frame;
+    {
+        logger::LogReader reader(path);
+        reader.seek(header);
+        reader.nextHeader(&frame);
+    }
+    auto dataEnd = dataBegin + frame.dataLen;
+    CHECK(hasEveryEntry(tamper(header, static_cast<char>(0x80)), target));
+    CHECK(hasEveryEntry(tamper(dataBegin, 0x01), target));
+    CHECK(hasEveryEntry(tamper(dataEnd - 1, 0x01), target));
+}
+
+int main()
+{
+    testCbcRoundTrip();
+    testGcmRoundTrip();
+    testManyRecordsWithOneKey();
+
+    auto dir = makeTestDirectory("crypto-test");
+    crypto::AsymKey asymKey;
+    asymKey.generate();
+    testCbcLogFile(dir, &asymKey);
+    testGcmLogFile(dir, &asymKey);
+
+    std::filesystem::remove_all(dir);
+    return TEST_RESULT;
+}
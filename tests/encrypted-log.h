@@ -0,0 +1,79 @@
+#ifndef TESTS_ENCRYPTED_LOG
+#define TESTS_ENCRYPTED_LOG
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "capturer.h"
+#include "config.h"
+#include "crypto.h"
+#include "logger.h"
+
+/// @brief Config of a logger writing encrypted log files in `dir / "logs"`,
+///        with the public key of `asymKey`. Snapshots are synthetic, as the
+///        tests write their own entries.
+inline Config makeEncryptedConfig(const std::filesystem::path &dir, crypto::AsymKey *asymKey)
+{
+    auto publicKeyPath = dir / "main.rsa-public.data";
+    asymKey->saveToFile(crypto::KeyTypePublic, publicKeyPath.u8string());
+
+    Config config;
+    config.outDir = (dir / "logs").u8string();
+    config.encryption.enabled = true;
+    config.encryption.rsaPublicKeyPath = publicKeyPath.u8string();
+    config.capture.source = "replay";
+    return config;
+}
+
+/// @brief Snapshot of a single app, told apart from the others by `index`.
+inline LogEntry makeEntry(time_t timestamp, int index)
+{
+    LogEntry entry;
+    entry.timestamp = timestamp;
+    AppRecord app;
+    app.path = "/usr/bin/app-" + std::to_string(index);
+    app.title = "Window " + std::to_string(index);
+    app.isActive = true;
+    entry.apps.push_back(app);
+    return entry;
+}
+
+/// @brief Does the decrypted `text` hold the entry made by `makeEntry(..., index)`?
+inline bool isEntry(const std::string &text, int index)
+{
+    return text.find("\"/usr/bin/app-" + std::to_string(index) + "\"") != std::string::npos;
+}
+
+/// @brief The only log file the logger has written in `dir / "logs"`.
+inline std::filesystem::path findLogFile(const std::filesystem::path &dir)
+{
+    std::filesystem::path found;
+    for (auto &file : std::filesystem::directory_iterator(dir / "logs"))
+        found = file.path();
+    return found;
+}
+
+/// @brief Keeps the text of every decrypted entry.
+class CollectingLogSink : public logger::LogSink
+{
+public:
+    std::vector<std::string> entries;
+
+    void writeEntry(const char *text, size_t textLen) override
+    {
+        this->entries.emplace_back(text, textLen);
+    }
+};
+
+/// @brief Decrypt every entry of an encrypted log file.
+inline std::vector<std::string> decryptEntries(const std::filesystem::path &path,
+                                               crypto::AsymKey *asymKey,
+                                               unsigned int threads = 1)
+{
+    logger::LogDecryptor decryptor(asymKey);
+    CollectingLogSink sink;
+    decryptor.decryptFile(path, &sink, threads);
+    return sink.entries;
+}
+
+#endif /* TESTS_ENCRYPTED_LOG */
@@ -0,0 +1,122 @@
+#include <string>
+#include <vector>
+
+#include "crypto.h"
+#include "key-cache.h"
+#include "test.h"
+
+/// @brief Wrap the secret of `symKey` with RSA, as the logger does in a key frame.
+static std::vector<CryptoPP::byte> wrap(crypto::AsymKey *asymKey, crypto::SymKey *symKey)
+{
+    std::vector<CryptoPP::byte> secret(symKey->getSecretLen());
+    symKey->getSecret(secret.data(), secret.size());
+    std::vector<CryptoPP::byte> wrapped(asymKey->calculateCipherLen());
+    asymKey->encrypt(secret.data(), secret.size(), wrapped.data(), wrapped.size());
+    return wrapped;
+}
+
+static bool sameSecret(crypto::SymKey *a, crypto::SymKey *b)
+{
+    std::vector<CryptoPP::byte> secretA(a->getSecretLen()), secretB(b->getSecretLen());
+    a->getSecret(secretA.data(), secretA.size());
+    b->getSecret(secretB.data(), secretB.size());
+    return secretA == secretB;
+}
+
+static void testHitAndMiss(crypto::AsymKey *asymKey)
+{
+    crypto::SymKey first, second;
+    first.generateRandom();
+    second.generateRandom();
+    auto wrappedFirst = wrap(asymKey, &first);
+    auto wrappedSecond = wrap(asymKey, &second);
+
+    crypto::KeyCache cache;
+    crypto::SymKey *unwrapped = cache.unwrap(asymKey, wrappedFirst.data(), wrappedFirst.size());
+    CHECK(sameSecret(unwrapped, &first));
+    delete unwrapped;
+    CHECK(cache.getStats().misses == 1);
+    CHECK(cache.getStats().hits == 0);
+
+    // The same wrapped key is a hit, and needs no RSA key at all.
+    unwrapped = cache.unwrap(nullptr, wrappedFirst.data(), wrappedFirst.size());
+    CHECK(sameSecret(unwrapped, &first));
+    delete unwrapped;
+    CHECK(cache.getStats().hits == 1);
+
+    // RSA-OAEP is randomized, so wrapping the same key again gives
+    // another wrapped form, which is another entry.
+    unwrapped = cache.unwrap(asymKey, wrappedSecond.data(), wrappedSecond.size());
+    CHECK(sameSecret(unwrapped, &second));
+    delete unwrapped;
+    auto rewrapped = wrap(asymKey, &first);
+    unwrapped = cache.unwrap(asymKey, rewrapped.data(), rewrapped.size());
+    CHECK(sameSecret(unwrapped, &first));
+    delete unwrapped;
+
+    auto stats = cache.getStats();
+    CHECK(stats.hits == 1);
+    CHECK(stats.misses == 3);
+    CHECK(stats.getHitRate() == 0.25);
+    CHECK(cache.size() == 3);
+
+    // A wrapped key that does not decrypt is not cached.
+    auto corrupted = wrappedFirst;
+    corrupted[corrupted.size() / 2] ^= 0x01;
+    CHECK_THROWS(crypto::DecryptionError, delete cache.unwrap(asymKey, corrupted.data(), corrupted.size()));
+    CHECK(cache.size() == 3);
+}
+
+static void testPersistedRoundTrip(crypto::AsymKey *asymKey)
+{
+    auto dir = makeTestDirectory("key-cache-test");
+    auto path = (dir / "key-cache.data.enc").u8string();
+
+    crypto::SymKey first, second;
+    first.generateRandom();
+    second.generateRandom();
+    auto wrappedFirst = wrap(asymKey, &first);
+    auto wrappedSecond = wrap(asymKey, &second);
+
+    crypto::SymKey cacheKey;
+    cacheKey.generateRandom();
+    {
+        crypto::KeyCache cache;
+        delete cache.unwrap(asymKey, wrappedFirst.data(), wrappedFirst.size());
+        delete cache.unwrap(asymKey, wrappedSecond.data(), wrappedSecond.size());
+        cache.saveToFile(path, &cacheKey);
+    }
+    CHECK(!std::filesystem::exists(path + ".tmp"));
+
+    // Both keys are hits in a new cache loaded from the file,
+    // so no RSA key is needed to unwrap them.
+    crypto::KeyCache loaded;
+    loaded.loadFromFile(path, &cacheKey);
+    CHECK(loaded.size() == 2);
+    crypto::SymKey *unwrapped = loaded.unwrap(nullptr, wrappedFirst.data(), wrappedFirst.size());
+    CHECK(sameSecret(unwrapped, &first));
+    delete unwrapped;
+    unwrapped = loaded.unwrap(nullptr, wrappedSecond.data(), wrappedSecond.size());
+    CHECK(sameSecret(unwrapped, &second));
+    delete unwrapped;
+    CHECK(loaded.getStats().hits == 2);
+    CHECK(loaded.getStats().misses == 0);
+
+    // The file cannot be read with another key.
+    crypto::SymKey otherKey;
+    otherKey.generateRandom();
+    crypto::KeyCache wrongKey;
+    CHECK_THROWS(crypto::CryptoError, wrongKey.loadFromFile(path, &otherKey));
+
+    std::filesystem::remove_all(dir);
+}
+
+int main()
+{
+    crypto::AsymKey asymKey;
+    asymKey.generate();
+
+    testHitAndMiss(&asymKey);
+    testPersistedRoundTrip(&asymKey);
+    return TEST_RESULT;
+}
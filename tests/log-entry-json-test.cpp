@@ -0,0 +1,123 @@
+#include <string>
+#include <vector>
+
+#include "capturer.h"
+#include "log-entry-json.h"
+#include "test.h"
+
+static void addApp(LogEntry *entry, const std::string &path, const std::string &title, bool isActive = false)
+{
+    AppRecord &app = entry->apps.emplace_back();
+    app.path = path;
+    app.title = title;
+    app.isActive = isActive;
+}
+
+/// @brief Check the serialized entry is exactly `golden`, which
+///        is what the JSON DOM of earlier versions also gives.
+static void checkGolden(const LogEntry &entry, const std::string &golden)
+{
+    std::vector<char> out;
+    writeLogEntryJson(entry, &out);
+    std::string text(out.begin(), out.end());
+    if (text != golden)
+        std::fprintf(stderr, "Got      %s\nExpected %s\n", text.c_str(), golden.c_str());
+    CHECK(text == golden);
+
+    auto dom = logEntryToJson(entry).dump(-1, ' ', false, nlohmann::json::error_handler_t::replace);
+    CHECK(dom == golden);
+}
+
+static void testEmptyAppList()
+{
+    LogEntry entry;
+    entry.timestamp = 1704067200;
+    checkGolden(entry, "{\"apps\":[],\"time\":1704067200}");
+}
+
+static void testSnapshot()
+{
+    LogEntry entry;
+    entry.timestamp = 1704067200;
+    addApp(&entry, "C:\\Windows\\explorer.exe", "Documents");
+    addApp(&entry, "C:\\Program Files\\Mozilla Firefox\\firefox.exe", "Mozilla Firefox", true);
+    addApp(&entry, "", "");
+    checkGolden(entry, "{\"apps\":["
+                       "{\"path\":\"C:\\\\Windows\\\\explorer.exe\",\"title\":\"Documents\"},"
+                       "{\"isActive\":true,\"path\":\"C:\\\\Program Files\\\\Mozilla Firefox\\\\firefox.exe\","
+                       "\"title\":\"Mozilla Firefox\"},"
+                       "{\"path\":\"\",\"title\":\"\"}"
+                       "],\"time\":1704067200}");
+}
+
+static void testEscaping()
+{
+    LogEntry entry;
+    entry.timestamp = 0;
+    addApp(&entry, "/bin/\"quoted\"/back\\slash", "tab\tnew\nline\rcr\bbs\fff\x01\x1f\x7f/end");
+    checkGolden(entry, "{\"apps\":[{\"path\":\"/bin/\\\"quoted\\\"/back\\\\slash\","
+                       "\"title\":\"tab\\tnew\\nline\\rcr\\bbs\\fff\\u0001\\u001f\x7f/end\"}],\"time\":0}");
+
+    LogEntry nul;
+    nul.timestamp = 1;
+    addApp(&nul, std::string("a\0b", 3), "");
+    checkGolden(nul, "{\"apps\":[{\"path\":\"a\\u0000b\",\"title\":\"\"}],\"time\":1}");
+}
+
+static void testNonAscii()
+{
+    // Two, three and four byte UTF-8 is written as it is, not escaped.
+    LogEntry entry;
+    entry.timestamp = 1704067200;
+    addApp(&entry, "C:\\Users\\Ren\xC3\xA9\\app.exe", "\xE6\x97\xA5\xE6\x9C\xAC\xE8\xAA\x9E \xE2\x82\xAC", true);
+    addApp(&entry, "/chat", "Chat \xF0\x9F\x98\x80");
+    checkGolden(entry, "{\"apps\":["
+                       "{\"isActive\":true,\"path\":\"C:\\\\Users\\\\Ren\xC3\xA9\\\\app.exe\","
+                       "\"title\":\"\xE6\x97\xA5\xE6\x9C\xAC\xE8\xAA\x9E \xE2\x82\xAC\"},"
+                       "{\"path\":\"/chat\",\"title\":\"Chat \xF0\x9F\x98\x80\"}"
+                       "],\"time\":1704067200}");
+}
+
+static void testInvalidUtf8()
+{
+    // Invalid bytes are replaced with U+FFFD, as nlohmann's lenient mode does.
+    LogEntry entry;
+    entry.timestamp = 1704067200;
+    addApp(&entry, "/bad", "a\xFF" "b\xC3");
+    checkGolden(entry, "{\"apps\":[{\"path\":\"/bad\",\"title\":\"a\xEF\xBF\xBD" "b\xEF\xBF\xBD\"}],"
+                       "\"time\":1704067200}");
+}
+
+static void testIdle()
+{
+    LogEntry entry;
+    entry.type = LogEntryIdle;
+    entry.timestamp = 1704067200;
+    entry.durationSinceLastInput = 75;
+    checkGolden(entry, "{\"durationSinceLastInput\":75,\"timestamp\":1704067200}");
+}
+
+static void testFocus()
+{
+    // `isActive` is implied, and never written.
+    LogEntry entry;
+    entry.type = LogEntryFocus;
+    entry.timestamp = 1704067260;
+    entry.focus.path = "/usr/bin/vim";
+    entry.focus.title = "notes \"draft\"";
+    entry.focus.isActive = true;
+    checkGolden(entry, "{\"focus\":{\"path\":\"/usr/bin/vim\",\"title\":\"notes \\\"draft\\\"\"},"
+                       "\"time\":1704067260}");
+}
+
+int main()
+{
+    testEmptyAppList();
+    testSnapshot();
+    testEscaping();
+    testNonAscii();
+    testInvalidUtf8();
+    testIdle();
+    testFocus();
+    return TEST_RESULT;
+}
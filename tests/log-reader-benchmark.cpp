@@ -0,0 +1,72 @@
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+#include <vector>
+
+#include "frame-buffer.h"
+#include "log-reader.h"
+#include "test.h"
+
+/// @brief Write a version `B` log file of `frameCount` frames of random data,
+///        as long as the encrypted entries of a typical capture.
+static void writeLogFile(const std::filesystem::path &path, size_t frameCount)
+{
+    std::mt19937 random(42);
+    std::ofstream file(path, std::ios::binary);
+    file.put(ENC_LOGFILE_VERSION_GCM);
+
+    std::vector<char> data(4096);
+    for (auto &c : data)
+        c = static_cast<char>(random());
+
+    for (size_t i = 0; i < frameCount; i++)
+    {
+        size_t dataLen = 256 + random() % 3072;
+        unsigned char header[FRAME_HEADER_LEN];
+        logger::encodeFrameHeader(logger::DataTypeJson, dataLen, header);
+        file.write(reinterpret_cast<char *>(header), FRAME_HEADER_LEN);
+        file.write(data.data(), dataLen);
+    }
+}
+
+/// @brief Walk every frame, touching every byte of its data, and print the throughput.
+static void run(const char *name, const std::filesystem::path &path, bool useMapping, int rounds)
+{
+    unsigned long long bytes = 0, checksum = 0, frames = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; round++)
+    {
+        logger::LogReader reader(path, useMapping);
+        logger::LogFrame frame;
+        while (reader.next(&frame))
+        {
+            for (size_t i = 0; i < frame.dataLen; i++)
+                checksum += frame.data[i];
+            bytes += frame.dataLen + FRAME_HEADER_LEN;
+            frames++;
+        }
+    }
+    double seconds = secondsSince(start);
+    std::printf("%-22s %9.1f MB/s  %10.0f frames/s  (checksum %llu)\n",
+                name, bytes / seconds / 1e6, frames / seconds, checksum);
+}
+
+int main(int argc, char **argv)
+{
+    // The workload is scaled by the first argument.
+    int scale = argc > 1 ? std::atoi(argv[1]) : 100;
+    auto dir = makeTestDirectory("log-reader-benchmark");
+    auto path = dir / "20240101.json.log.enc";
+
+    // About 1.7 MB per unit of scale. The file is read from the page cache,
+    // as it has just been written, so this measures the read path, not the disk.
+    writeLogFile(path, 1000 * scale);
+    std::printf("%llu bytes\n", static_cast<unsigned long long>(std::filesystem::file_size(path)));
+
+    run("memory mapping", path, true, 5);
+    run("stdio reads", path, false, 5);
+
+    std::filesystem::remove_all(dir);
+    return EXIT_SUCCESS;
+}
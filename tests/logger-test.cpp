@@ -0,0 +1,125 @@
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <new>
+#include <optional>
+#include <string>
+
+#include "capture-arena.h"
+#include "config.h"
+#include "logger.h"
+#include "test.h"
+
+/// Every heap allocation of the test, through any `operator new`.
+static std::atomic<unsigned long long> heapAllocations{0};
+
+void *operator new(std::size_t size)
+{
+    heapAllocations++;
+    if (void *p = std::malloc(size == 0 ? 1 : size))
+        return p;
+    throw std::bad_alloc();
+}
+
+void *operator new(std::size_t size, std::align_val_t alignment)
+{
+    heapAllocations++;
+    auto align = static_cast<std::size_t>(alignment);
+    if (void *p = std::aligned_alloc(align, (size + align - 1) / align * align))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, std::align_val_t) noexcept
+{
+    std::free(p);
+}
+
+/// @brief Config of a logger writing plain log files in `dir`,
+///        and capturing from a replay of `snapshots` (one JSON per line).
+static Config makeReplayConfig(const std::filesystem::path &dir, const std::string &snapshots)
+{
+    auto replayPath = dir / "replay.json.log";
+    std::ofstream(replayPath) << snapshots;
+
+    Config config;
+    config.outDir = (dir / "logs").u8string();
+    config.encryption.enabled = false;
+    config.capture.source = "replay";
+    config.capture.replayPath = replayPath.u8string();
+    return config;
+}
+
+static void testCaptureFocusWithoutForegroundApp()
+{
+    auto dir = makeTestDirectory("logger-test-focus");
+    auto config = makeReplayConfig(dir, "{\"apps\":[{\"path\":\"/a\",\"title\":\"A\",\"isActive\":true}]}\n"
+                                        "{\"apps\":[{\"path\":\"/b\",\"title\":\"B\"}]}\n"
+                                        "{\"apps\":[{\"path\":\"/a\",\"title\":\"A\",\"isActive\":true}]}\n"
+                                        "{\"apps\":[{\"path\":\"/c\",\"title\":\"C\",\"isActive\":true}]}\n");
+    logger::Logger logger(&config);
+    LogEntry entry;
+    logger.capture(1704067200, &entry);
+
+    // No app in the foreground is not a change of focus...
+    CHECK(!logger.captureFocus(1704067201, &entry));
+    // ... so coming back to the same app is not one either.
+    CHECK(!logger.captureFocus(1704067202, &entry));
+
+    CHECK(logger.captureFocus(1704067203, &entry));
+    CHECK(entry.type == LogEntryFocus);
+    CHECK(entry.focus.path == "/c");
+    CHECK(entry.focus.title == "C");
+}
+
+static void testSteadyStateCapturesDoNotAllocate()
+{
+    // Paths and titles are longer than the small string buffer,
+    // so copying them into new strings would allocate.
+    auto dir = makeTestDirectory("logger-test-allocations");
+    auto config = makeReplayConfig(
+        dir, "{\"apps\":[{\"path\":\"/usr/lib/firefox/firefox-bin\",\"title\":\"Mozilla Firefox - Start Page\","
+             "\"isActive\":true},{\"path\":\"/usr/bin/gnome-terminal-server\",\"title\":\"Terminal - owl\"}]}\n"
+             "{\"apps\":[{\"path\":\"/usr/lib/firefox/firefox-bin\",\"title\":\"Mozilla Firefox - Start Page\"},"
+             "{\"path\":\"/usr/bin/gnome-terminal-server\",\"title\":\"Terminal - owl\",\"isActive\":true}]}\n");
+    logger::Logger logger(&config);
+
+    // Entries live in an arena, as in the queue slots of `LogPipeline`.
+    CaptureArena arena;
+    std::optional<LogEntry> entry;
+    time_t timestamp = 1704067200;
+    auto tick = [&]()
+    {
+        // The focus changes between every capture and probe.
+        entry.reset();
+        arena.reset();
+        logger.capture(timestamp++, &entry.emplace(arena.resource()));
+        entry.reset();
+        arena.reset();
+        CHECK(logger.captureFocus(timestamp++, &entry.emplace(arena.resource())));
+    };
+
+    // The arena and the reused strings reach their size first.
+    for (int i = 0; i < 10; i++)
+        tick();
+
+    auto allocationsBefore = heapAllocations.load();
+    auto arenaStatsBefore = arena.getStats();
+    for (int i = 0; i < 100; i++)
+        tick();
+
+    CHECK(heapAllocations.load() == allocationsBefore);
+    CHECK(arena.getStats().ticksWithHeapAllocations == arenaStatsBefore.ticksWithHeapAllocations);
+}
+
+int main()
+{
+    testCaptureFocusWithoutForegroundApp();
+    testSteadyStateCapturesDoNotAllocate();
+    return TEST_RESULT;
+}
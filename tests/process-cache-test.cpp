@@ -0,0 +1,66 @@
+#include <string>
+
+#include "process-cache.h"
+#include "test.h"
+
+static void testFindSeenOnlyDuringCapture()
+{
+    ProcessCache cache;
+    cache.beginCapture();
+    cache.insert(42, 1000, "C:\\old.exe");
+    CHECK(cache.findSeen(42) != nullptr);
+    CHECK(cache.findSeen(43) == nullptr);
+    cache.endCapture();
+
+    // Between captures (e.g. on a focus probe), the process may have exited
+    // and its id been reused, so it must be looked up with its start time.
+    CHECK(cache.findSeen(42) == nullptr);
+    CHECK(cache.find(42, 2000) == nullptr);
+    CHECK(cache.insert(42, 2000, "C:\\new.exe") == "C:\\new.exe");
+    CHECK(cache.find(42, 2000) != nullptr && *cache.find(42, 2000) == "C:\\new.exe");
+}
+
+static void testReusedProcessId()
+{
+    ProcessCache cache;
+    cache.beginCapture();
+    cache.insert(7, 1000, "C:\\first.exe");
+    cache.endCapture();
+
+    cache.beginCapture();
+    CHECK(cache.findSeen(7) == nullptr);
+    CHECK(cache.find(7, 1001) == nullptr);
+    cache.insert(7, 1001, "C:\\second.exe");
+    CHECK(cache.findSeen(7) != nullptr && *cache.findSeen(7) == "C:\\second.exe");
+    cache.endCapture();
+}
+
+static void testEviction()
+{
+    ProcessCache cache;
+    cache.beginCapture();
+    cache.insert(1, 10, "C:\\one.exe");
+    cache.insert(2, 20, "C:\\two.exe");
+    cache.endCapture();
+
+    cache.beginCapture();
+    CHECK(cache.find(1, 10) != nullptr);
+    cache.endCapture();
+
+    auto stats = cache.getStats();
+    CHECK(stats.size == 1);
+    CHECK(stats.evictions == 1);
+
+    cache.beginCapture();
+    CHECK(cache.find(2, 20) == nullptr);
+    CHECK(cache.find(1, 10) != nullptr);
+    cache.endCapture();
+}
+
+int main()
+{
+    testFindSeenOnlyDuringCapture();
+    testReusedProcessId();
+    testEviction();
+    return TEST_RESULT;
+}
@@ -0,0 +1,136 @@
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "encrypted-log.h"
+#include "log-query.h"
+#include "log-reader.h"
+#include "test.h"
+
+/// UNIX timestamp of the first entry, at noon of the first log file's day.
+#define QUERY_TEST_START 1704110400
+
+/// @brief Append `count` entries to the log file of the day `day` days after
+///        the first one, numbered from `first`. Each file is of version 'A',
+///        whose frames are not authenticated.
+static void writeEntries(const std::filesystem::path &dir, crypto::AsymKey *asymKey,
+                         int day, int first, int count)
+{
+    auto config = makeEncryptedConfig(dir, asymKey);
+    config.encryption.keyGenRate = 100;
+    auto path = dir / "logs" / ("2024010" + std::to_string(day + 1) + ".json.log.enc");
+    if (!std::filesystem::exists(path))
+        std::ofstream(path, std::ios::binary).put(ENC_LOGFILE_VERSION_CBC);
+
+    logger::Logger logger(&config);
+    for (int i = first; i < first + count; i++)
+        logger.write(makeEntry(QUERY_TEST_START + day * 86400 + i, i));
+}
+
+/// @brief Append an entry frame holding `text`, encrypted with the last key
+///        of the version 'A' file, as an entry altered into garbage reads.
+static void appendRawEntry(const std::filesystem::path &path, crypto::AsymKey *asymKey,
+                           const std::string &text)
+{
+    std::unique_ptr<crypto::SymKey> key;
+    {
+        logger::LogReader reader(path);
+        logger::LogFrame frame;
+        while (reader.next(&frame))
+            if (frame.type == logger::DataTypeSymKey)
+            {
+                std::vector<CryptoPP::byte> secret(frame.dataLen);
+                size_t secretLen = 0;
+                asymKey->decrypt(frame.data, frame.dataLen, secret.data(), secret.size(), &secretLen);
+                key.reset(new crypto::SymKey(secret.data(), secretLen));
+            }
+    }
+
+    std::vector<CryptoPP::byte> plain(text.begin(), text.end());
+    std::vector<CryptoPP::byte> cipher(key->calculateCipherLen(plain.size()));
+    key->encrypt(plain.data(), plain.size(), cipher.data(), cipher.size());
+
+    unsigned char header[FRAME_HEADER_LEN];
+    logger::encodeFrameHeader(logger::DataTypeJson, cipher.size(), header);
+    std::ofstream file(path, std::ios::binary | std::ios::app);
+    file.write(reinterpret_cast<const char *>(header), FRAME_HEADER_LEN);
+    file.write(reinterpret_cast<const char *>(cipher.data()), cipher.size());
+}
+
+static bool hasEntries(const std::vector<std::string> &entries, const std::vector<int> &expected)
+{
+    if (entries.size() != expected.size())
+        return false;
+    for (size_t i = 0; i < expected.size(); i++)
+        if (!isEntry(entries[i], expected[i]))
+            return false;
+    return true;
+}
+
+/// @brief Three small files, decrypted into memory in one batch. The first has
+///        an entry that is not JSON, the second one the sinks cannot use.
+static void writeDamagedFiles(const std::filesystem::path &dir, crypto::AsymKey *asymKey)
+{
+    std::filesystem::remove_all(dir / "logs");
+    std::filesystem::create_directories(dir / "logs");
+
+    writeEntries(dir, asymKey, 0, 0, 2);
+    appendRawEntry(dir / "logs" / "20240101.json.log.enc", asymKey, "\x01\x02 not an entry");
+    writeEntries(dir, asymKey, 0, 2, 2);
+
+    writeEntries(dir, asymKey, 1, 4, 2);
+    appendRawEntry(dir / "logs" / "20240102.json.log.enc", asymKey, "{\"apps\":[],\"time\":\"noon\"}");
+    writeEntries(dir, asymKey, 1, 6, 1);
+
+    writeEntries(dir, asymKey, 2, 7, 2);
+}
+
+static void testFilterSkipsDamagedEntries(const std::filesystem::path &dir, crypto::AsymKey *asymKey)
+{
+    CollectingLogSink out;
+    logger::LogEntryFilter filter(&out);
+    logger::DecryptionOptions options;
+    options.threads = 2;
+    auto summary = logger::queryLogFiles(dir / "logs", asymKey, &filter, options);
+
+    // The entry that is not JSON is skipped and counted. The second file
+    // stops at the entry the filter cannot use, and the third one is still read.
+    CHECK(filter.getDiscarded() == 1);
+    CHECK(hasEntries(out.entries, {0, 1, 2, 3, 4, 5, 7, 8}));
+    CHECK(summary.results.size() == 3);
+    CHECK(summary.failed == 1);
+    if (summary.results.size() == 3)
+    {
+        CHECK(summary.results[0].error.empty());
+        CHECK(!summary.results[1].error.empty());
+        CHECK(summary.results[2].error.empty());
+    }
+}
+
+static void testAggregatorSkipsDamagedEntries(const std::filesystem::path &dir, crypto::AsymKey *asymKey)
+{
+    logger::AppUsageAggregator aggregator(60);
+    logger::DecryptionOptions options;
+    options.threads = 2;
+    auto summary = logger::queryLogFiles(dir / "logs", asymKey, &aggregator, options);
+
+    CHECK(aggregator.getDiscarded() == 1);
+    CHECK(summary.failed == 1);
+    // Every app but the one after the entry the aggregator cannot use was active.
+    CHECK(aggregator.getUsage().size() == 8);
+}
+
+int main()
+{
+    auto dir = makeTestDirectory("query-test");
+    crypto::AsymKey asymKey;
+    asymKey.generate();
+
+    writeDamagedFiles(dir, &asymKey);
+    testFilterSkipsDamagedEntries(dir, &asymKey);
+    testAggregatorSkipsDamagedEntries(dir, &asymKey);
+
+    std::filesystem::remove_all(dir);
+    return TEST_RESULT;
+}
@@ -0,0 +1,203 @@
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "encrypted-log.h"
+#include "log-reader.h"
+#include "test.h"
+
+/// Least length (in bytes) of the part of the log file decrypted by a resumed run,
+/// so it is split into several chunks of `DECRYPTION_CHUNK_MIN_LEN` (1 MiB) bytes.
+#define RESUMED_MIN_LEN 4194304
+
+/// @brief Entry about as long as a snapshot of two dozen apps.
+static LogEntry makeLargeEntry(time_t timestamp, int index)
+{
+    auto entry = makeEntry(timestamp, index);
+    for (int i = 0; i < 24; i++)
+    {
+        AppRecord app;
+        app.path = "/opt/suite/bin/tool-" + std::to_string(i);
+        app.title = "Project " + std::to_string(index) + " - a window title as long as those of browsers and editors";
+        entry.apps.push_back(app);
+    }
+    return entry;
+}
+
+static std::vector<CryptoPP::byte> getSecret(crypto::SymKey *symKey)
+{
+    std::vector<CryptoPP::byte> secret(symKey->getSecretLen());
+    symKey->getSecret(secret.data(), secret.size());
+    return secret;
+}
+
+static void testSegmentKeyDerivation()
+{
+    // HKDF-SHA256 without salt, of the label followed by the big-endian segment number,
+    // as computed by an independent implementation. It is part of the file format.
+    CryptoPP::byte secret[16] = {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+                                 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f};
+    crypto::SymKey fileKey(secret, sizeof(secret));
+    struct
+    {
+        unsigned long long segment;
+        std::vector<CryptoPP::byte> key;
+    } expected[] = {
+        {1, {0x4e, 0x71, 0xdb, 0x00, 0xe9, 0x7a, 0x7a, 0x5a, 0x68, 0xbb, 0xc6, 0x72, 0x92, 0x6e, 0x2f, 0xba}},
+        {2, {0x82, 0xdc, 0x39, 0xef, 0x73, 0xfa, 0x71, 0xb5, 0x6f, 0x70, 0x63, 0xff, 0xc9, 0x10, 0x67, 0xe3}},
+        {0x0102030405060708, {0x74, 0x53, 0xd6, 0x8d, 0xe9, 0x67, 0x9c, 0x72, 0xe2, 0xc7, 0x7a, 0x22, 0x75, 0x6e, 0x17, 0xcc}},
+    };
+    for (auto &[segment, key] : expected)
+    {
+        std::unique_ptr<crypto::SymKey> segmentKey(fileKey.deriveSegmentKey(segment));
+        CHECK(getSecret(segmentKey.get()) == key);
+    }
+}
+
+/// @brief Read a log file written by the logger frame by frame, unwrapping and
+///        deriving its keys without `LogDecryptor`, so the writer is checked
+///        against the format rather than against the reader.
+static void testWriterDerivesSegmentKeys(const std::filesystem::path &dir, crypto::AsymKey *asymKey)
+{
+    std::filesystem::remove_all(dir / "logs");
+    auto config = makeEncryptedConfig(dir, asymKey);
+    config.encryption.keyGenRate = 2;
+    {
+        logger::Logger logger(&config);
+        for (int i = 0; i < 10; i++)
+            logger.write(makeEntry(1704110400 + i, i));
+    }
+
+    std::unique_ptr<crypto::SymKey> fileKey, key;
+    unsigned long long lastSegment = 0, counter = 0;
+    int keyFrames = 0, segmentFrames = 0, entries = 0;
+    bool segmentsCount = true, entriesDecrypt = true;
+    std::vector<CryptoPP::byte> plain;
+
+    logger::LogReader reader(findLogFile(dir));
+    logger::LogFrame frame;
+    while (reader.next(&frame))
+        if (frame.type == logger::DataTypeSymKey)
+        {
+            std::vector<CryptoPP::byte> secret(frame.dataLen);
+            size_t secretLen = 0;
+            asymKey->decrypt(frame.data, frame.dataLen, secret.data(), secret.size(), &secretLen);
+            fileKey.reset(new crypto::SymKey(secret.data(), secretLen));
+            key.reset(new crypto::SymKey(secret.data(), secretLen));
+            lastSegment = counter = 0;
+            keyFrames++;
+        }
+        else if (frame.type == logger::DataTypeSegmentKey)
+        {
+            // Segments are numbered from 1 after each key frame, in big-endian.
+            unsigned long long segment = 0;
+            for (size_t i = 0; i < frame.dataLen; i++)
+                segment = (segment << 8) | frame.data[i];
+            segmentsCount = segmentsCount && frame.dataLen == SEGMENT_NUMBER_LEN && segment == lastSegment + 1;
+            lastSegment = segment;
+            key.reset(fileKey->deriveSegmentKey(segment));
+            counter = 0;
+            segmentFrames++;
+        }
+        else
+        {
+            // The nonce counts the entries since the key or segment key frame.
+            unsigned char header[FRAME_HEADER_LEN];
+            logger::encodeFrameHeader(frame.type, frame.dataLen, header, frame.compressed);
+            plain.resize(frame.dataLen);
+            try
+            {
+                plain.resize(key->decryptAuthenticated(frame.data, frame.dataLen, counter++,
+                                                       header, FRAME_HEADER_LEN,
+                                                       plain.data(), plain.size()));
+                entriesDecrypt = entriesDecrypt &&
+                                 isEntry(std::string(plain.begin(), plain.end()), entries);
+            }
+            catch (const crypto::DecryptionError &)
+            {
+                entriesDecrypt = false;
+            }
+            entries++;
+        }
+
+    // One RSA-wrapped key for the file, then a derived key every 3 entries.
+    CHECK(keyFrames == 1);
+    CHECK(segmentFrames == 3);
+    CHECK(segmentsCount);
+    CHECK(entries == 10);
+    CHECK(entriesDecrypt);
+}
+
+static bool hasEntries(const std::vector<std::string> &entries, int count)
+{
+    if (entries.size() != static_cast<size_t>(count))
+        return false;
+    for (int i = 0; i < count; i++)
+        if (!isEntry(entries[i], i))
+            return false;
+    return true;
+}
+
+/// @brief Resume the parallel decryption of a file the logger kept appending to
+///        with the same file key, so the resumed part only has segment key frames.
+static void testResumeAcrossChunks(const std::filesystem::path &dir, crypto::AsymKey *asymKey)
+{
+    std::filesystem::remove_all(dir / "logs");
+    auto config = makeEncryptedConfig(dir, asymKey);
+    config.encryption.keyGenRate = 10;
+    logger::Logger logger(&config);
+    for (int i = 0; i < 300; i++)
+        logger.write(makeLargeEntry(1704110400 + i, i));
+    logger.flush();
+    auto path = findLogFile(dir);
+
+    CollectingLogSink sink;
+    logger::DecryptionProgress progress;
+    {
+        logger::LogDecryptor decryptor(asymKey);
+        decryptor.decryptFile(path, &sink, 4, &progress);
+    }
+    CHECK(hasEntries(sink.entries, 300));
+    CHECK(progress.keyOffset != 0);
+
+    int total = 300;
+    while (std::filesystem::file_size(path) - progress.offset < RESUMED_MIN_LEN)
+    {
+        logger.write(makeLargeEntry(1704110400 + total, total));
+        total++;
+    }
+    logger.flush();
+
+    // Every segment of the resumed part is derived from the key the last run stopped at.
+    auto segments = logger::scanSegments(path, progress.offset, progress.keyOffset);
+    CHECK(segments.size() > 4);
+    bool derivedFromLastKey = true;
+    for (auto &segment : segments)
+        derivedFromLastKey = derivedFromLastKey && segment.keyOffset == progress.keyOffset;
+    CHECK(derivedFromLastKey);
+
+    // A new run continues with the chunks decrypted in parallel,
+    // without losing or repeating an entry.
+    {
+        logger::LogDecryptor decryptor(asymKey);
+        decryptor.decryptFile(path, &sink, 4, &progress);
+    }
+    CHECK(hasEntries(sink.entries, total));
+    CHECK(progress.offset == std::filesystem::file_size(path));
+
+    CHECK(hasEntries(decryptEntries(path, asymKey, 4), total));
+}
+
+int main()
+{
+    testSegmentKeyDerivation();
+
+    auto dir = makeTestDirectory("segments-test");
+    crypto::AsymKey asymKey;
+    asymKey.generate();
+    testWriterDerivesSegmentKeys(dir, &asymKey);
+    testResumeAcrossChunks(dir, &asymKey);
+
+    std::filesystem::remove_all(dir);
+    return TEST_RESULT;
+}
@@ -0,0 +1,57 @@
+#ifndef TESTS_TEST
+#define TESTS_TEST
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+
+/// Number of failed checks, returned by `main` as `TEST_RESULT`.
+inline int testFailures = 0;
+
+/// @brief Report the condition and where it is if it does not hold,
+///        and carry on, so one run reports every failure.
+#define CHECK(condition)                                                               \
+    do                                                                                 \
+    {                                                                                  \
+        if (!(condition))                                                              \
+        {                                                                              \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+            testFailures++;                                                            \
+        }                                                                              \
+    } while (false)
+
+/// @brief Check that `statement` throws an exception of type `Error`.
+#define CHECK_THROWS(Error, statement) \
+    do                                 \
+    {                                  \
+        bool thrown = false;           \
+        try                            \
+        {                              \
+            statement;                 \
+        }                              \
+        catch (const Error &)          \
+        {                              \
+            thrown = true;             \
+        }                              \
+        CHECK(thrown && #statement);   \
+    } while (false)
+
+#define TEST_RESULT (testFailures == 0 ? EXIT_SUCCESS : EXIT_FAILURE)
+
+/// @brief Empty directory of the test, created anew under the system's temporary directory.
+inline std::filesystem::path makeTestDirectory(const std::string &name)
+{
+    auto path = std::filesystem::temp_directory_path() / ("watchful-owl-" + name);
+    std::filesystem::remove_all(path);
+    std::filesystem::create_directories(path);
+    return path;
+}
+
+/// @brief Seconds elapsed since `start`, on a monotonic clock.
+inline double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+#endif /* TESTS_TEST */
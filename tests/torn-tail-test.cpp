@@ -0,0 +1,154 @@
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "encrypted-log.h"
+#include "log-reader.h"
+#include "test.h"
+
+/// Number of entries in the log file every torn copy is cut from.
+#define TORN_TAIL_ENTRIES 40
+/// Number of random offsets the log file is cut at, besides every offset of its last frames.
+#define TORN_TAIL_RANDOM_CUTS 60
+
+/// @brief A frame of the intact log file.
+struct FrameBounds
+{
+    logger::DataType type;
+    unsigned long long end;
+};
+
+static std::vector<FrameBounds> readFrameBounds(const std::filesystem::path &path)
+{
+    std::vector<FrameBounds> frames;
+    logger::LogReader reader(path);
+    logger::LogFrame frame;
+    while (reader.nextHeader(&frame))
+        frames.push_back({frame.type, frame.offset + FRAME_HEADER_LEN + frame.dataLen});
+    return frames;
+}
+
+static std::string readFile(const std::filesystem::path &path)
+{
+    std::ifstream file(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+/// @brief Cut the log file at `cut`, as if the logger was killed while writing
+///        the byte at that offset, then check that every complete entry is read
+///        back, and that the logger appends readable entries to the file again.
+static void checkCut(const std::filesystem::path &dir, crypto::AsymKey *asymKey,
+                     const std::string &intact, const std::vector<FrameBounds> &frames, size_t cut)
+{
+    // Where the logger writes the entries of the day, so a new logger opens the torn file.
+    auto path = dir / "logs" / "20240101.json.log.enc";
+    std::filesystem::remove_all(dir / "logs");
+    std::filesystem::create_directories(dir / "logs");
+    std::ofstream(path, std::ios::binary).write(intact.data(), cut);
+
+    unsigned long long lastComplete = 1;
+    int completeEntries = 0;
+    for (auto &frame : frames)
+        if (frame.end <= cut)
+        {
+            lastComplete = frame.end;
+            if (frame.type == logger::DataTypeJson)
+                completeEntries++;
+        }
+
+    // The reader skips the torn frame on its own...
+    auto entries = decryptEntries(path, asymKey);
+    bool recovered = entries.size() == static_cast<size_t>(completeEntries);
+    for (int i = 0; recovered && i < completeEntries; i++)
+        recovered = isEntry(entries[i], i);
+    if (!recovered)
+        std::fprintf(stderr, "Entries lost when cut at %zu of %zu bytes\n", cut, intact.size());
+    CHECK(recovered);
+
+    // ... and the writer cuts it off before appending, so the new entry
+    // does not land in the middle of it.
+    auto config = makeEncryptedConfig(dir, asymKey);
+    {
+        logger::Logger logger(&config);
+        logger.write(makeEntry(1704110400, TORN_TAIL_ENTRIES));
+    }
+    CHECK(readFile(path).compare(0, lastComplete, intact, 0, lastComplete) == 0);
+
+    entries = decryptEntries(path, asymKey);
+    recovered = entries.size() == static_cast<size_t>(completeEntries + 1) &&
+                isEntry(entries.back(), TORN_TAIL_ENTRIES);
+    for (int i = 0; recovered && i < completeEntries; i++)
+        recovered = isEntry(entries[i], i);
+    if (!recovered)
+        std::fprintf(stderr, "Entries lost when appending after a cut at %zu of %zu bytes\n", cut, intact.size());
+    CHECK(recovered);
+}
+
+static void testTrimTornTail(const std::filesystem::path &dir, const std::string &intact,
+                             const std::vector<FrameBounds> &frames)
+{
+    auto path = dir / "trim.json.log.enc";
+
+    // An intact file is left alone.
+    std::ofstream(path, std::ios::binary).write(intact.data(), intact.size());
+    CHECK(logger::trimTornTail(path) == 0);
+    CHECK(std::filesystem::file_size(path) == intact.size());
+
+    // A torn header and torn data are both cut off.
+    auto lastFrameBegin = frames[frames.size() - 2].end;
+    for (auto cut : {lastFrameBegin + 2, lastFrameBegin + FRAME_HEADER_LEN + 1})
+    {
+        std::ofstream(path, std::ios::binary).write(intact.data(), cut);
+        CHECK(logger::trimTornTail(path) == cut - lastFrameBegin);
+        CHECK(std::filesystem::file_size(path) == lastFrameBegin);
+    }
+
+    // So is a frame torn before its first byte is written, leaving only the version.
+    std::ofstream(path, std::ios::binary).write(intact.data(), 3);
+    CHECK(logger::trimTornTail(path) == 2);
+    CHECK(std::filesystem::file_size(path) == 1);
+    std::filesystem::remove(path);
+}
+
+int main()
+{
+    auto dir = makeTestDirectory("torn-tail-test");
+    crypto::AsymKey asymKey;
+    asymKey.generate();
+
+    // Key frames and segment key frames are among the frames cut.
+    auto config = makeEncryptedConfig(dir, &asymKey);
+    config.encryption.keyGenRate = 7;
+    {
+        logger::Logger logger(&config);
+        for (int i = 0; i < TORN_TAIL_ENTRIES; i++)
+            logger.write(makeEntry(1704110400 + i, i));
+    }
+    auto intactPath = dir / "intact.json.log.enc";
+    std::filesystem::rename(findLogFile(dir), intactPath);
+    auto intact = readFile(intactPath);
+    auto frames = readFrameBounds(intactPath);
+    CHECK(decryptEntries(intactPath, &asymKey).size() == TORN_TAIL_ENTRIES);
+
+    testTrimTornTail(dir, intact, frames);
+
+    // Every offset within the key frames and the last three frames,
+    // which covers torn headers and torn data of every type of frame...
+    unsigned long long begin = 1;
+    for (size_t i = 0; i < frames.size(); i++)
+    {
+        if (frames[i].type != logger::DataTypeJson || i + 3 >= frames.size())
+            for (auto cut = begin; cut < frames[i].end; cut++)
+                checkCut(dir, &asymKey, intact, frames, cut);
+        begin = frames[i].end;
+    }
+    // ... and offsets anywhere in the file.
+    std::mt19937 random(20240101);
+    for (int i = 0; i < TORN_TAIL_RANDOM_CUTS; i++)
+        checkCut(dir, &asymKey, intact, frames, 1 + random() % (intact.size() - 1));
+
+    std::filesystem::remove_all(dir);
+    return TEST_RESULT;
+}
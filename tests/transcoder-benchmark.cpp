@@ -0,0 +1,61 @@
+#include <codecvt>
+#include <cstdio>
+#include <cstdlib>
+#include <locale>
+#include <string>
+#include <vector>
+
+#include "test.h"
+#include "transcoder.h"
+
+/// @brief Transcode as `toUtf8` did before the transcoder, with a converter per call.
+static std::string convertWithCodecvt(const std::u16string &in)
+{
+    std::wstring_convert<std::codecvt_utf8_utf16<char16_t>, char16_t> converter;
+    return converter.to_bytes(in);
+}
+
+/// @brief Print the throughput (in MB/s of UTF-16 input) of transcoding every title `rounds` times.
+template <typename Transcode>
+static void run(const char *name, const std::vector<std::u16string> &titles, int rounds, Transcode transcode)
+{
+    size_t bytes = 0, outputLen = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; round++)
+        for (auto &title : titles)
+        {
+            outputLen += transcode(title);
+            bytes += title.size() * sizeof(char16_t);
+        }
+    double seconds = secondsSince(start);
+    std::printf("%-28s %9.1f MB/s  %8.1f ns/title  (%zu bytes out)\n",
+                name, bytes / seconds / 1e6, seconds * 1e9 / (rounds * titles.size()), outputLen);
+}
+
+int main(int argc, char **argv)
+{
+    // The workload is scaled by the first argument.
+    int scale = argc > 1 ? std::atoi(argv[1]) : 100;
+    int rounds = 1000 * scale;
+
+    // Window titles and executable paths, as a capture gives them.
+    std::vector<std::u16string> titles = {
+        u"C:\\Program Files\\Google\\Chrome\\Application\\chrome.exe",
+        u"Inbox - someone@example.com - Outlook",
+        u"main.cpp - watchful-owl - Visual Studio Code",
+        u"C:\\Windows\\explorer.exe",
+        u"Caf\u00E9 menu \u2013 Notepad",
+        u"\u65E5\u672C\u8A9E\u306E\u30BF\u30A4\u30C8\u30EB - Word",
+        u"Chat \U0001F600 - Discord",
+    };
+
+    std::string out;
+    run("utf16ToUtf8 (reused string)", titles, rounds, [&](const std::u16string &title) {
+        utf16ToUtf8(title.data(), title.size(), &out);
+        return out.size();
+    });
+    run("wstring_convert per call", titles, rounds, [&](const std::u16string &title) {
+        return convertWithCodecvt(title).size();
+    });
+    return EXIT_SUCCESS;
+}
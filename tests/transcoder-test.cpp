@@ -0,0 +1,182 @@
+#include <random>
+#include <string>
+#include <vector>
+
+#include "test.h"
+#include "transcoder.h"
+
+/// @brief Transcode code point by code point, to compare the transcoder against.
+static std::string referenceUtf8(const std::u16string &in)
+{
+    std::string out;
+    for (size_t i = 0; i < in.size(); i++)
+    {
+        char32_t c = in[i];
+        if (c >= 0xD800 && c <= 0xDBFF && i + 1 < in.size() && in[i + 1] >= 0xDC00 && in[i + 1] <= 0xDFFF)
+            c = 0x10000 + ((c - 0xD800) << 10) + (in[++i] - 0xDC00);
+        else if (c >= 0xD800 && c <= 0xDFFF)
+            c = 0xFFFD;
+
+        if (c < 0x80)
+            out += static_cast<char>(c);
+        else if (c < 0x800)
+            out += {static_cast<char>(0xC0 | (c >> 6)), static_cast<char>(0x80 | (c & 0x3F))};
+        else if (c < 0x10000)
+            out += {static_cast<char>(0xE0 | (c >> 12)), static_cast<char>(0x80 | ((c >> 6) & 0x3F)),
+                    static_cast<char>(0x80 | (c & 0x3F))};
+        else
+            out += {static_cast<char>(0xF0 | (c >> 18)), static_cast<char>(0x80 | ((c >> 12) & 0x3F)),
+                    static_cast<char>(0x80 | ((c >> 6) & 0x3F)), static_cast<char>(0x80 | (c & 0x3F))};
+    }
+    return out;
+}
+
+/// @brief Transcode into a buffer of exactly `utf8MaxLen` bytes, followed by
+///        guard bytes that must be left untouched.
+static std::string transcode(const std::u16string &in)
+{
+    const size_t guardLen = 16;
+    std::vector<char> buffer(utf8MaxLen(in.size()) + guardLen, '#');
+    size_t len = utf16ToUtf8(in.data(), in.size(), buffer.data());
+
+    CHECK(len <= utf8MaxLen(in.size()));
+    for (size_t i = utf8MaxLen(in.size()); i < buffer.size(); i++)
+        CHECK(buffer[i] == '#');
+    return std::string(buffer.data(), len);
+}
+
+static void testEmpty()
+{
+    CHECK(transcode(u"") == "");
+    std::string out = "previous content";
+    utf16ToUtf8(u"", 0, &out);
+    CHECK(out.empty());
+}
+
+static void testAscii()
+{
+    // Every length around the 8 code units the ASCII fast path takes at a time.
+    std::u16string in;
+    std::string expected;
+    for (size_t len = 0; len <= 40; len++)
+    {
+        CHECK(transcode(in) == expected);
+        char c = static_cast<char>(len == 0 ? '\0' : 0x20 + len % 0x5F);
+        in += static_cast<char16_t>(c);
+        expected += c;
+    }
+    CHECK(transcode(std::u16string(1, u'\x7F')) == "\x7F");
+}
+
+static void testEncodingBoundaries()
+{
+    CHECK(transcode(u"\u0080") == "\xC2\x80");
+    CHECK(transcode(u"\u00E9") == "\xC3\xA9");
+    CHECK(transcode(u"\u07FF") == "\xDF\xBF");
+    CHECK(transcode(u"\u0800") == "\xE0\xA0\x80");
+    CHECK(transcode(u"\u20AC") == "\xE2\x82\xAC");
+    CHECK(transcode(u"\uD7FF") == "\xED\x9F\xBF");
+    CHECK(transcode(u"\uE000") == "\xEE\x80\x80");
+    CHECK(transcode(u"\uFFFF") == "\xEF\xBF\xBF");
+}
+
+static void testSurrogatePairs()
+{
+    CHECK(transcode(u"\U00010000") == "\xF0\x90\x80\x80");
+    CHECK(transcode(u"\U0001F600") == "\xF0\x9F\x98\x80");
+    CHECK(transcode(u"\U0010FFFF") == "\xF4\x8F\xBF\xBF");
+    CHECK(transcode(u"a\U0001F600b") == "a\xF0\x9F\x98\x80" "b");
+}
+
+static void testUnpairedSurrogates()
+{
+    const std::string replacement = "\xEF\xBF\xBD";
+    std::u16string highAtEnd = u"ab";
+    highAtEnd += char16_t(0xD83D);
+    CHECK(transcode(highAtEnd) == "ab" + replacement);
+
+    std::u16string highThenAscii = {char16_t(0xD83D), u'a'};
+    CHECK(transcode(highThenAscii) == replacement + "a");
+
+    std::u16string lowAlone = {u'a', char16_t(0xDE00), u'b'};
+    CHECK(transcode(lowAlone) == "a" + replacement + "b");
+
+    std::u16string reversed = {char16_t(0xDE00), char16_t(0xD83D)};
+    CHECK(transcode(reversed) == replacement + replacement);
+
+    // The second high surrogate still pairs with the low one after it.
+    std::u16string twoHighs = {char16_t(0xD83D), char16_t(0xD83D), char16_t(0xDE00)};
+    CHECK(transcode(twoHighs) == replacement + "\xF0\x9F\x98\x80");
+}
+
+static void testNonAsciiAroundFastPath()
+{
+    // A non-ASCII unit at every position of the first 8-unit blocks,
+    // so the fast path stops, and resumes, at each of them.
+    for (size_t position = 0; position < 24; position++)
+    {
+        std::u16string in(24, u'x');
+        in[position] = u'\u00E9';
+        CHECK(transcode(in) == referenceUtf8(in));
+    }
+}
+
+static void testWorstCaseLength()
+{
+    // Three-byte characters reach `utf8MaxLen` exactly.
+    std::u16string in(33, u'\u20AC');
+    CHECK(transcode(in).size() == utf8MaxLen(in.size()));
+}
+
+static void testRandomAgainstReference()
+{
+    std::mt19937 random(20240101);
+    std::uniform_int_distribution<int> kind(0, 9);
+    for (int run = 0; run < 2000; run++)
+    {
+        std::u16string in(random() % 64, u'\0');
+        for (auto &unit : in)
+        {
+            // Mostly ASCII, like titles and paths, with every other range mixed in.
+            int k = kind(random);
+            if (k < 6)
+                unit = static_cast<char16_t>(random() % 0x80);
+            else if (k == 6)
+                unit = static_cast<char16_t>(0x80 + random() % 0x780);
+            else if (k == 7)
+                unit = static_cast<char16_t>(0x800 + random() % 0xF800);
+            else
+                unit = static_cast<char16_t>(0xD800 + random() % 0x800);
+        }
+        CHECK(transcode(in) == referenceUtf8(in));
+    }
+}
+
+static void testStringReusesCapacity()
+{
+    std::u16string in(100, u'\u00E9');
+    std::string out;
+    utf16ToUtf8(in.data(), in.size(), &out);
+    CHECK(out == referenceUtf8(in));
+
+    auto capacity = out.capacity();
+    const char *data = out.data();
+    utf16ToUtf8(u"short", 5, &out);
+    CHECK(out == "short");
+    CHECK(out.capacity() == capacity);
+    CHECK(out.data() == data);
+}
+
+int main()
+{
+    testEmpty();
+    testAscii();
+    testEncodingBoundaries();
+    testSurrogatePairs();
+    testUnpairedSurrogates();
+    testNonAsciiAroundFastPath();
+    testWorstCaseLength();
+    testRandomAgainstReference();
+    testStringReusesCapacity();
+    return TEST_RESULT;
+}
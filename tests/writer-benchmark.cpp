@@ -0,0 +1,70 @@
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+
+#include "config.h"
+#include "log-writer.h"
+#include "test.h"
+
+/// @brief Append as `Logger::append` did before `LogWriter`:
+///        check the file exists, then open, write and close it per entry.
+static void appendReopening(const std::filesystem::path &path, const std::string &entry)
+{
+    if (!std::filesystem::exists(path))
+        std::ofstream(path).close();
+    std::ofstream file(path, std::ios_base::app);
+    file << entry << "\n";
+}
+
+static void report(const char *name, int entries, double seconds)
+{
+    std::printf("%-34s %10.0f entries/s\n", name, entries / seconds);
+}
+
+static void runWriter(const char *name, const std::filesystem::path &dir, const std::string &entry,
+                      int entries, const std::string &policy)
+{
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    FlushConfig flushConfig;
+    flushConfig.policy = policy;
+
+    time_t timestamp = 1704067200;
+    auto start = std::chrono::steady_clock::now();
+    {
+        logger::LogWriter writer(dir, ".txt", false, flushConfig);
+        for (int i = 0; i < entries; i++)
+        {
+            writer.open(timestamp);
+            writer.write(entry.data(), entry.size());
+            writer.commit();
+        }
+    }
+    report(name, entries, secondsSince(start));
+}
+
+int main(int argc, char **argv)
+{
+    // The workload is scaled by the first argument.
+    int scale = argc > 1 ? std::atoi(argv[1]) : 100;
+    int entries = 200 * scale;
+    auto dir = makeTestDirectory("writer-benchmark");
+
+    std::string entry = "{\"time\":1704067200,\"apps\":[{\"path\":\"C:\\\\Windows\\\\explorer.exe\","
+                        "\"title\":\"Documents\",\"isActive\":true}]}\n";
+
+    auto before = dir / "before";
+    std::filesystem::create_directories(before);
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < entries; i++)
+        appendReopening(before / "20240101.txt", entry.substr(0, entry.size() - 1));
+    report("reopen per entry (before)", entries, secondsSince(start));
+
+    runWriter("LogWriter, flush per entry", dir / "entry", entry, entries, "entry");
+    runWriter("LogWriter, flush every 10", dir / "count", entry, entries, "count");
+    runWriter("LogWriter, flush every interval", dir / "interval", entry, entries, "interval");
+
+    std::filesystem::remove_all(dir);
+    return EXIT_SUCCESS;
+}